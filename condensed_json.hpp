@@ -19,7 +19,7 @@ class CondensedJSON {
 		enum CondensedPrefix : uint8_t {
 			HALF_PRECISION_FLOAT = 0b10000000,
 			SHORT_STRING = 0b01100000,
-			RESERVED_1 = 0b01111110,
+			REFERENCE = 0b01111110,
 			LONG_STRING = 0b01111111,
 			MINIMAL_INTEGER = 0b01000000,
 			COMMON_OBJECT = 0b00111000,
@@ -69,37 +69,128 @@ class CondensedJSON {
 		constexpr static int RESERVED_4_MASK = 0x03;
 	};
 
-	struct ObjectMapEntry {
-		int index;
-		bool used = false;
-	};
-
 	using JSON = Serialisable::JSON;
 	using String = Serialisable::JSON::String;
 
 public:
+	constexpr static bool binary = true; // Serialisers may use representations that are more compact in binary
+
+	/*!
+	* \brief Tables and scratch buffers kept between calls, so that encoding or decoding similar data doesn't allocate them again
+	*
+	* \note Each thread has its own default one, one context must not be used by two calls at once
+	*/
+	class Context {
+		struct Layout {
+			int occurrences = 0;
+			int index = -1; // Identifier if objects with this layout are batched, -1 if they aren't
+			bool used = false; // If its names were already written
+		};
+		struct Dictionary {
+			std::vector<std::string> names;
+			size_t size = 0;
+			bool defined = false;
+		};
+		constexpr static size_t MAX_LAYOUTS = 4096; // More are forgotten, not to keep layouts of unrelated data forever
+
+		// Writing
+		std::unordered_map<std::string, Layout> layouts;
+		std::vector<Layout*> batched;
+		std::vector<std::pair<std::string, const JSON*>> members; // Sorted members of the objects being written, as a stack
+		size_t membersUsed = 0;
+		std::string descriptor;
+
+		// Reading
+		std::vector<std::unique_ptr<Dictionary>> dictionaries;
+		std::vector<std::string> names; // Names of members of the unique objects being read, as a stack
+		size_t namesUsed = 0;
+		std::string text;
+		std::streambuf* input = nullptr; // Where more data are read from when parsing a stream
+		std::unique_ptr<uint8_t[]> inputBuffer;
+
+		friend class CondensedJSON;
+	public:
+		static Context& local() {
+			thread_local Context context;
+			return context;
+		}
+	};
+
 	static std::vector<uint8_t> serialise(const JSON& source) {
 		std::vector<uint8_t> result;
-		auto mapping = generateObjectMapping(source);
-		writeCondensed(source, result, mapping);
+		serialiseInto(source, result);
 		return result;
 	}
 
+	// Appends to anything that has push_back(uint8_t), for example a reused buffer or memory that is going to be sent elsewhere
+	template <typename Sink>
+	static void serialiseInto(const JSON& source, Sink& sink, Context& context = Context::local()) {
+		generateObjectMapping(source, context);
+		writeCondensed(source, sink, context);
+	}
+
 	static JSON deserialise(const std::vector<uint8_t>& source) {
-		const uint8_t* data = source.data() - 1;
-		std::vector<std::unique_ptr<std::vector<std::string>>> objects;
-		return parseCondensed(data, source.data() + source.size(), objects);
+		return deserialiseBytes(source.data(), source.size());
+	}
+
+	// Reads the data where they are, without copying them into a vector first
+	static JSON deserialiseBytes(const uint8_t* source, size_t size, Context& context = Context::local()) {
+		const uint8_t* data = source - 1;
+		const uint8_t* end = source + size;
+		startParsing(context);
+		return parseCondensed(data, end, context);
+	}
+
+	// Parses the data while they are being read, keeping only a part of them in memory, it may read past the end of the data
+	static JSON fromStream(std::istream& stream, Context& context = Context::local()) {
+		startParsing(context);
+		if (!context.inputBuffer)
+			context.inputBuffer.reset(new uint8_t[INPUT_CHUNK_SIZE + 1]);
+		context.inputBuffer[0] = 0;
+		struct InputScope {
+			Context& context;
+			~InputScope() {
+				context.input = nullptr;
+			}
+		} scope = { context };
+		context.input = stream.rdbuf();
+		const uint8_t* source = context.inputBuffer.get();
+		const uint8_t* end = source + 1;
+		return parseCondensed(source, end, context);
 	}
 private:
-	static JSON parseCondensed(uint8_t const*& source, const uint8_t* end, std::vector<std::unique_ptr<std::vector<std::string>>>& objects) {
+	constexpr static size_t INPUT_CHUNK_SIZE = 1 << 16;
+
+	static void startParsing(Context& context) {
+		for (auto& it : context.dictionaries)
+			if (it)
+				it->defined = false;
+		context.namesUsed = 0;
+	}
+
+	// Reads more data from the stream if parsing one, keeping the current byte in front of them, false if there are no more
+	static bool refill(uint8_t const*& source, const uint8_t*& end, Context& context) {
+		if (!context.input)
+			return false;
+		uint8_t* buffer = context.inputBuffer.get();
+		buffer[0] = *source;
+		std::streamsize got = context.input->sgetn(reinterpret_cast<char*>(buffer + 1), INPUT_CHUNK_SIZE);
+		if (got <= 0)
+			return false;
+		source = buffer;
+		end = buffer + 1 + got;
+		return true;
+	}
+
+	static JSON parseCondensed(uint8_t const*& source, const uint8_t*& end, Context& context) {
 		// Recursion invariant: source always points to 1 byte before the start of the object
 		auto next = [&] () {
-			source++;
-			if (source >= end)
+			if (source + 1 >= end && !refill(source, end, context))
 				throw std::runtime_error("Condensed JSON got to an unexpected end of data");
+			source++;
 		};
 		auto peek = [&] () {
-			if (source + 1 >= end)
+			if (source + 1 >= end && !refill(source, end, context))
 				throw std::runtime_error("Condensed JSON got to an unexpected end of data");
 			return *(source + 1);
 		};
@@ -111,40 +202,59 @@ private:
 			}
 			return made;
 		};
-		auto readCodeString = [&] () {
+		auto readCodeString = [&] (std::string& made) {
 			next();
+			made.clear();
 			if (*source == CondensedInfo::STRING_FINAL_BIT_FLIP)
-				return std::string("");
+				return;
 
-			std::string made;
 			while (true) {
 				if (*source < CondensedInfo::STRING_FINAL_BIT_FLIP) {
 					made.push_back(*source);
 					next();
 				} else {
 					made.push_back(*source & 0x7f);
-					return made;
+					return;
 				}
 			}
 		};
-		auto parseObjectUsingDict = [&] (const std::vector<std::string>& names) {
+		auto parseObjectUsingDict = [&] (const std::vector<std::string>& names, size_t start, size_t count) {
 			JSON made;
-			made.setObject();
-			for (const std::string& it : names) {
-				made[it] = parseCondensed(source, end, objects);
+			JSON::ObjectType& object = made.setObject();
+			object.reserve(count);
+			for (size_t i = 0; i < count; i++) {
+				JSON value = parseCondensed(source, end, context); // May add names, so they are accessed only after it
+				object[names[start + i]] = std::move(value);
 			}
 			return made;
 		};
 		auto parseObject = [&] (const int index) {
-			if (int(objects.size()) < index + 1)
-				objects.resize(index + 1);
-			if (!objects[index]) {
-				objects[index] = std::make_unique<std::vector<std::string>>();
-				while (peek() != CondensedInfo::TERMINATOR)
-					objects[index]->push_back(readCodeString());
+			if (int(context.dictionaries.size()) < index + 1)
+				context.dictionaries.resize(index + 1);
+			if (!context.dictionaries[index])
+				context.dictionaries[index] = std::make_unique<Context::Dictionary>();
+			Context::Dictionary& dictionary = *context.dictionaries[index];
+			if (!dictionary.defined) {
+				dictionary.size = 0;
+				while (peek() != CondensedInfo::TERMINATOR) {
+					if (dictionary.names.size() == dictionary.size)
+						dictionary.names.emplace_back();
+					readCodeString(dictionary.names[dictionary.size++]);
+				}
+				dictionary.defined = true;
 				next();
 			}
-			return parseObjectUsingDict(*objects[index]);
+			return parseObjectUsingDict(dictionary.names, 0, dictionary.size);
+		};
+		auto pushName = [&] () -> std::string& {
+			if (context.names.size() == context.namesUsed)
+				context.names.emplace_back();
+			return context.names[context.namesUsed++];
+		};
+		auto parseUniqueObject = [&] (size_t start) {
+			JSON made = parseObjectUsingDict(context.names, start, context.namesUsed - start);
+			context.namesUsed = start;
+			return made;
 		};
 
 		next();
@@ -155,23 +265,27 @@ private:
 			result |= uint64_t(*source) << 44; // Mantissa
 			return JSON(*reinterpret_cast<double*>(&result));
 		} else if (*source == CondensedInfo::LONG_STRING) {
-			std::string made;
+			std::string& made = context.text;
+			made.clear();
 			next();
 			while (*source) {
 				made.push_back(*source);
 				next();
 			};
-			return JSON(made);
-		} else if (*source == CondensedInfo::RESERVED_1) {
-			throw(std::runtime_error("Condensed JSON version is too low"));
+			return SerialisableInternals::StringInterner::parsed(made);
+		} else if (*source == CondensedInfo::REFERENCE) {
+			JSON made;
+			made.setObject()[SerialisableInternals::SharedObjectTracking::REFERENCE_KEY] = parseCondensed(source, end, context);
+			return made;
 		} else if ((*source & 0b11100000) == CondensedInfo::SHORT_STRING) {
-			std::string made;
+			std::string& made = context.text;
+			made.clear();
 			int length = *source & CondensedInfo::SHORT_STRING_MASK;
 			for (int i = 0; i < length; i++) {
 				next();
 				made.push_back(*source);
 			}
-			return JSON(made);
+			return SerialisableInternals::StringInterner::parsed(made);
 		} else if ((*source & 0b11100000) == CondensedInfo::MINIMAL_INTEGER) {
 			int64_t made = (*source & CondensedInfo::MINIMAL_INTEGER_NUMBER_MASK);
 			if (*source & CondensedInfo::MINIMAL_INTEGER_SIGN_MASK)
@@ -193,48 +307,55 @@ private:
 			int index = *source & CondensedInfo::OBJECT_MASK;
 			return parseObject(index);
 		} else if (*source == CondensedInfo::LARGE_UNIQUE_OBJECT) {
-			std::vector<std::string> names;
+			size_t start = context.namesUsed;
 			while (peek() != CondensedInfo::TERMINATOR) {
-				names.push_back(readCodeString());
+				readCodeString(pushName());
 			}
 			next();
-			return parseObjectUsingDict(names);
+			return parseUniqueObject(start);
 		} else if (*source == CondensedInfo::HASHTABLE) {
-			std::vector<std::string> names;
+			size_t start = context.namesUsed;
 			next();
 			while (*source != CondensedInfo::TERMINATOR) {
-				std::string made;
+				std::string& made = pushName();
+				made.clear();
 				while (*source != CondensedInfo::TERMINATOR) {
 					made.push_back(*source);
 					next();
 				}
 				next();
-				names.push_back(made);
 			}
 			if (peek() == CondensedInfo::TERMINATOR) {
-				names.push_back("");
+				pushName().clear();
 				next();
 			}
-			return parseObjectUsingDict(names);
+			return parseUniqueObject(start);
 		} else if ((*source & 0xf0) == CondensedInfo::SMALL_UNIQUE_OBJECT) {
 			int size = *source & CondensedInfo::OBJECT_MASK;
-			std::vector<std::string> names;
+			size_t start = context.namesUsed;
 			for (int i = 0; i < size; i++)
-				names.push_back(readCodeString());
-			return parseObjectUsingDict(names);
+				readCodeString(pushName());
+			return parseUniqueObject(start);
 		} else if (*source == CondensedInfo::LONG_ARRAY) {
-			JSON made;
-			made.setArray();
-			while (peek() != CondensedInfo::TERMINATOR)
-				made.push_back(parseCondensed(source, end, objects));
-			made.array().shrink_to_fit();
-			return made;
+			SerialisableInternals::ParsingStacks& stacks = SerialisableInternals::ParsingStacks::local();
+			size_t start = stacks.elements.size();
+			try {
+				while (peek() != CondensedInfo::TERMINATOR) {
+					JSON element = parseCondensed(source, end, context);
+					stacks.elements.push_back(std::move(element));
+				}
+			} catch (...) {
+				stacks.elements.resize(start);
+				throw;
+			}
+			next();
+			return stacks.popArray(start);
 		} else if ((*source & 0xf0) == CondensedInfo::SHORT_ARRAY) {
 			JSON made;
 			int size = *source & CondensedInfo::SHORT_ARRAY_MASK;
 			made.setArray().reserve(size);
 			for (int i = 0; i < size; i++)
-				made.push_back(parseCondensed(source, end, objects));
+				made.push_back(parseCondensed(source, end, context));
 			return made;
 		} else if ((*source & 0xf0) == CondensedInfo::VERY_SHORT_INTEGER) {
 			int64_t made;
@@ -283,22 +404,25 @@ private:
 	}
 
 
-	static void writeCondensed(const JSON& source, std::vector<uint8_t>& buffer, std::unordered_map<std::string, ObjectMapEntry>& mapping) {
+	template <typename Buffer>
+	static void writeCondensed(const JSON& source, Buffer& buffer, Context& context) {
 		switch(source.type()) {
 		case JSON::Type::NIL:
 			buffer.push_back(CondensedInfo::NIL);
 			return;
 		case JSON::Type::STRING: {
-			std::string contents = source.string();
-			if (contents.size() < CondensedInfo::MAX_SHORT_STRING_SIZE) {
-				buffer.push_back(CondensedInfo::SHORT_STRING + contents.size());
-				for (auto c : contents) {
-					buffer.push_back(static_cast<uint8_t>(c));
+			JSON::ShortStringBuffer shortText;
+			size_t size = 0;
+			const char* contents = source.stringData(shortText, size);
+			if (size < CondensedInfo::MAX_SHORT_STRING_SIZE) {
+				buffer.push_back(CondensedInfo::SHORT_STRING + size);
+				for (size_t i = 0; i < size; i++) {
+					buffer.push_back(static_cast<uint8_t>(contents[i]));
 				}
 			} else {
 				buffer.push_back(CondensedInfo::LONG_STRING);
-				for (auto c : contents) {
-					buffer.push_back(static_cast<uint8_t>(c));
+				for (size_t i = 0; i < size; i++) {
+					buffer.push_back(static_cast<uint8_t>(contents[i]));
 				}
 				buffer.push_back(CondensedInfo::TERMINATOR);
 			}
@@ -384,15 +508,23 @@ private:
 				buffer.push_back(CondensedInfo::FALSE);
 			return;
 		case JSON::Type::OBJECT: {
-			auto contents = source.object();
+			const auto& contents = source.object();
 			if (contents.empty()) {
 				buffer.push_back(CondensedInfo::SMALL_UNIQUE_OBJECT); // Does not need to be saved
 				return;
 			}
-			std::pair<std::string, bool> descriptor = getDescriptor(contents);
-			if (descriptor.second) {
-				auto found = mapping.find(descriptor.first);
-				if (found != mapping.end()) {
+			const JSON* referenced = sharedObjectReference(contents);
+			if (referenced) {
+				buffer.push_back(CondensedInfo::REFERENCE);
+				writeCondensed(*referenced, buffer, context);
+				return;
+			}
+			size_t start = orderMembers(contents, source.leadingMember(), context);
+			size_t end = context.membersUsed;
+			if (describe(context, start)) {
+				const std::string& descriptor = context.descriptor;
+				auto found = context.layouts.find(descriptor);
+				if (found != context.layouts.end() && found->second.index >= 0) {
 					int index = found->second.index;
 					if (index <= CondensedInfo::MAX_COMMON_OBJECT_ID)
 						buffer.push_back(CondensedInfo::COMMON_OBJECT | index);
@@ -407,8 +539,8 @@ private:
 						buffer.push_back(index & 0xff);
 					}
 					if (!found->second.used) {
-						if (!descriptor.first.empty()) {
-							for (auto c : descriptor.first)
+						if (!descriptor.empty()) {
+							for (auto c : descriptor)
 								buffer.push_back(c);
 							buffer.push_back(CondensedInfo::TERMINATOR);
 							found->second.used = true;
@@ -417,41 +549,48 @@ private:
 				} else {
 					if (contents.size() < CondensedInfo::MAX_SMALL_UNIQUE_OBJECT_SIZE) {
 						buffer.push_back(CondensedInfo::SMALL_UNIQUE_OBJECT | contents.size());
-						for (auto c : descriptor.first)
+						for (auto c : descriptor)
 							buffer.push_back(c);
 					} else {
 						buffer.push_back(CondensedInfo::LARGE_UNIQUE_OBJECT);
-						for (auto c : descriptor.first)
+						for (auto c : descriptor)
 							buffer.push_back(c);
 						buffer.push_back(CondensedInfo::TERMINATOR);
 					}
 				}
 
-				auto ordered = getOrdered(contents);
-				for (auto& it : ordered) {
-					writeCondensed(it.second, buffer, mapping);
-				}
+				for (size_t i = start; i < end; i++) // Writing the members may move the stack, so it's accessed by index
+					writeCondensed(*context.members[i].second, buffer, context);
 			} else {
+				context.membersUsed = start;
 				buffer.push_back(CondensedInfo::HASHTABLE);
-				for (auto& it : contents) {
-					std::string name = it.first;
-					if (!name.empty()) {
-						for (auto c : name)
-							buffer.push_back(c);
-						buffer.push_back(CondensedInfo::TERMINATOR);
-					}
-				}
+				const char* leadingKey = source.leadingMember();
+				auto leading = leadingKey ? contents.find(leadingKey) : contents.end();
+				const void* leadingMember = (leading != contents.end()) ? &*leading : nullptr;
+				auto forEachNamed = [&] (auto function) { // The leading key first, the empty key is written separately
+					if (leadingMember)
+						function(*leading);
+					for (auto& it : contents)
+						if (&it != leadingMember && !(it.first == ""))
+							function(it);
+				};
+				forEachNamed([&] (const auto& it) {
+					it.first.copyTo(context.descriptor);
+					for (auto c : context.descriptor)
+						buffer.push_back(c);
+					buffer.push_back(CondensedInfo::TERMINATOR);
+				});
 				if (contents.find("") != contents.end()) // Empty string must go last
 					buffer.push_back(CondensedInfo::TERMINATOR);
 				buffer.push_back(CondensedInfo::TERMINATOR);
-				for (auto& it : contents)
-					if (!std::string(it.first).empty()) {
-						writeCondensed(it.second, buffer, mapping);
-					}
+				forEachNamed([&] (const auto& it) {
+					writeCondensed(it.second, buffer, context);
+				});
 				auto empty = contents.find("");
 				if (empty != contents.end())
-					writeCondensed(empty->second, buffer, mapping);
+					writeCondensed(empty->second, buffer, context);
 			}
+			context.membersUsed = start;
 			return;
 		}
 		case JSON::Type::ARRAY: {
@@ -459,11 +598,11 @@ private:
 			if (contents.size() < CondensedInfo::MAX_SHORT_ARRAY_SIZE) {
 				buffer.push_back(CondensedInfo::SHORT_ARRAY | contents.size());
 				for (auto& it : contents)
-					writeCondensed(it, buffer, mapping);
+					writeCondensed(it, buffer, context);
 			} else {
 				buffer.push_back(CondensedInfo::LONG_ARRAY);
 				for (auto& it : contents)
-					writeCondensed(it, buffer, mapping);
+					writeCondensed(it, buffer, context);
 				buffer.push_back(CondensedInfo::TERMINATOR);
 			}
 			return;
@@ -473,56 +612,85 @@ private:
 		}
 	}
 
-	static std::unordered_map<std::string, ObjectMapEntry> generateObjectMapping(const JSON& mapped) {
-		std::unordered_map<String, int, Serialisable::JSON::StringHasher> list;
-		addToObjectList(mapped, list);
+	static void generateObjectMapping(const JSON& mapped, Context& context) {
+		if (context.layouts.size() > Context::MAX_LAYOUTS)
+			context.layouts.clear();
+		for (auto& it : context.layouts)
+			it.second = Context::Layout();
+		context.membersUsed = 0;
+		addToObjectList(mapped, context);
 
-		std::vector<std::pair<std::string, int>> ordered;
-		for (auto& it : list) {
-			ordered.push_back(std::move(it));
-		}
-		std::sort(ordered.begin(), ordered.end(), [] (std::pair<std::string, int> first, std::pair<std::string, int> second) {
-			return first.second > second.second;
+		context.batched.clear();
+		for (auto& it : context.layouts)
+			if (it.second.occurrences > 1) // Objects with a single occurrence are not saved this way
+				context.batched.push_back(&it.second);
+		std::sort(context.batched.begin(), context.batched.end(), [] (const Context::Layout* first, const Context::Layout* second) {
+			return first->occurrences > second->occurrences;
 		});
-
-		std::unordered_map<std::string, ObjectMapEntry> result;
-		for (unsigned int i = 0; i < ordered.size(); i++) {
-			if (ordered[i].second <= 1) break; // Objects with a single occurrence are not saved this way
+		for (unsigned int i = 0; i < context.batched.size(); i++) {
 			if (i > 0xffff + CondensedInfo::MAX_UNCOMMON_OBJECT_ID) break; // Cannot batch so many object types
-			result[ordered[i].first] = { int(i) };
+			context.batched[i]->index = int(i);
 		}
-		return result;
 	}
 
-	static void addToObjectList(const JSON& mapped, std::unordered_map<String, int, Serialisable::JSON::StringHasher>& list) {
+	static void addToObjectList(const JSON& mapped, Context& context) {
 		if (mapped.type() == JSON::Type::OBJECT) {
 			auto& contents = mapped.object();
-			if (contents.empty())
+			if (contents.empty() || sharedObjectReference(contents))
 				return;
-			std::pair<std::string, bool> descriptor = getDescriptor(contents);
-			if (descriptor.second)
-				list[descriptor.first]++;
+			size_t start = orderMembers(contents, mapped.leadingMember(), context);
+			if (describe(context, start)) {
+				auto found = context.layouts.find(context.descriptor);
+				if (found == context.layouts.end())
+					found = context.layouts.emplace(context.descriptor, Context::Layout()).first;
+				found->second.occurrences++;
+			}
+			context.membersUsed = start;
 
 			for (auto& it : contents)
-				addToObjectList(it.second, list);
+				addToObjectList(it.second, context);
 		}
 	}
 
-	static std::vector<std::pair<String, JSON>> getOrdered(const JSON::ObjectType& mapped) {
-		// They must be sorted in order to notice identical objects
-		std::vector<std::pair<String, JSON>> ordered;
-		for (auto& it : mapped)
-			ordered.push_back(it);
-		std::sort(ordered.begin(), ordered.end(), [] (auto first, auto second) {
-			return std::string(first.first) < std::string(second.first);
+	// The identifier if the object is a reference to a shared object saved elsewhere, nullptr otherwise
+	static const JSON* sharedObjectReference(const JSON::ObjectType& contents) {
+		if (contents.size() != 1)
+			return nullptr;
+		auto found = contents.find(SerialisableInternals::SharedObjectTracking::REFERENCE_KEY);
+		if (found == contents.end() || found->second.type() != JSON::Type::NUMBER)
+			return nullptr;
+		return &found->second;
+	}
+
+	// Pushes the members of the object on the stack in the context, returns where they start
+	static size_t orderMembers(const JSON::ObjectType& mapped, const char* leadingKey, Context& context) {
+		// They must be sorted in order to notice identical objects, the leading key (if any) goes first so that the type is known early
+		size_t start = context.membersUsed;
+		context.membersUsed += mapped.size();
+		if (context.members.size() < context.membersUsed)
+			context.members.resize(context.membersUsed);
+		auto member = context.members.begin() + start;
+		for (auto& it : mapped) {
+			it.first.copyTo(member->first);
+			member->second = &it.second;
+			++member;
+		}
+		std::sort(context.members.begin() + start, context.members.begin() + context.membersUsed, [leadingKey] (const auto& first, const auto& second) {
+			bool firstLeading = (leadingKey && first.first == leadingKey);
+			bool secondLeading = (leadingKey && second.first == leadingKey);
+			if (firstLeading != secondLeading)
+				return firstLeading;
+			return first.first < second.first;
 		});
-		return ordered;
+		return start;
 	}
-	static std::pair<std::string, bool> getDescriptor(const JSON::ObjectType& object) {
-		std::string composed;
-		auto ordered = getOrdered(object);
-		for (auto& it : ordered) {
-			std::string field = it.first;
+
+	// Composes the names of the members on top of the stack into the context's descriptor, false if they aren't all ASCII
+	static bool describe(Context& context, size_t start) {
+		std::string& composed = context.descriptor;
+		composed.clear();
+		for (size_t member = start; member < context.membersUsed; member++) {
+			const std::string& field = context.members[member].first;
 			if (field.empty()) {
 				composed.push_back(CondensedInfo::STRING_FINAL_BIT_FLIP);
 			}
@@ -533,11 +701,11 @@ private:
 					else
 						composed.push_back(uint8_t(field[i]) | CondensedInfo::STRING_FINAL_BIT_FLIP);
 				} else {
-					return { "", false };
+					return false;
 				}
 			}
 		}
-		return { composed, true };
+		return true;
 	}
 
 };
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <iterator>
+#include <sstream>
 #include "serialisable_polymorphic.hpp"
+#include "condensed_json.hpp"
 
 struct ContentType : public SerialisablePolymorphic {
 	bool fullscreen = false;
@@ -29,6 +31,26 @@ struct Content2 : public ContentType {
 	SERIALISABLE_REGISTER_POLYMORPHIC(ContentType, Content2, "c2");
 };
 
+// Can point to another object of the hierarchy, possibly forming a cycle
+struct Linked : public ContentType {
+	std::shared_ptr<ContentType> other;
+	void serialisation() override {
+		ContentType::serialisation();
+		subclass("linked");
+		synch("other", other);
+	}
+	SERIALISABLE_REGISTER_POLYMORPHIC(ContentType, Linked, "linked");
+};
+
+struct Pair : public Serialisable {
+	std::shared_ptr<ContentType> a;
+	std::shared_ptr<ContentType> b;
+	void serialisation() override {
+		synch("a", a);
+		synch("b", b);
+	}
+};
+
 struct Parent : public Serialisable {
 	std::vector<std::shared_ptr<ContentType>> contents;
 	std::unique_ptr<ContentType> main;
@@ -38,11 +60,162 @@ struct Parent : public Serialisable {
 	}
 };
 
+// A hierarchy with its own name for the type member
+struct Shape : public SerialisablePolymorphic {
+	constexpr static const char* typeMember = "kind";
+	double size = 0;
+	void serialisation() override {
+		synch("size", size);
+	}
+};
+
+struct Circle : public Shape {
+	std::string type; // Only an ordinary member in this hierarchy
+	void serialisation() override {
+		Shape::serialisation();
+		subclass("circle");
+		synch("type", type);
+	}
+	SERIALISABLE_REGISTER_POLYMORPHIC(Shape, Circle, "circle");
+};
+
+// Not polymorphic, its member called type has no special meaning
+struct Label : public Serialisable {
+	std::string type;
+	std::string text;
+	void serialisation() override {
+		synch("text", text);
+		synch("type", type);
+	}
+};
+
+static std::string firstKey(const std::string& json) {
+	size_t start = json.find('"');
+	return json.substr(start + 1, json.find('"', start + 1) - start - 1);
+}
+
 int main(int argc, char** argv) {
+	bool correct = true;
 	Parent parent;
 	parent.load("polymorphs.json");
 	parent.contents.push_back(std::make_shared<Content1>());
 	parent.contents.push_back(std::make_shared<Content2>());
 	parent.save("polymorphs.json");
-	return 0;
+
+	// The type is written first, in the hierarchy's own member, other objects aren't reordered
+	{
+		Content1 content;
+		content.value = "text";
+		Circle circle;
+		circle.type = "round";
+		Label label;
+		label.type = "note";
+		if (firstKey(content.to<SerialisableInternals::JSONformat>()) != "type"
+				|| firstKey(circle.to<SerialisableInternals::JSONformat>()) != "kind") {
+			std::cout << "The type is not written first" << std::endl;
+			correct = false;
+		}
+		if (label.toJSON().leadingMember() != nullptr || circle.toJSON().leadingMember() != std::string("kind")) {
+			std::cout << "Wrong members are put first" << std::endl;
+			correct = false;
+		}
+		std::unique_ptr<Shape> shape;
+		std::stringstream stream(circle.to<SerialisableInternals::JSONformat>());
+		SerialisablePolymorphic::loadFromStream(shape, stream);
+		if (!dynamic_cast<Circle*>(shape.get()) || static_cast<Circle&>(*shape).type != "round") {
+			std::cout << "A hierarchy with its own type member was not loaded" << std::endl;
+			correct = false;
+		}
+	}
+
+	// The objects survive a round trip through both formats
+	{
+		Parent saved;
+		auto first = std::make_shared<Content1>();
+		first->value = "first";
+		saved.contents.push_back(first);
+		auto second = std::make_shared<Content2>();
+		second->value = 2.5;
+		second->fullscreen = true;
+		saved.contents.push_back(second);
+		saved.main = std::make_unique<Content1>();
+		for (int format = 0; format < 2; format++) {
+			Parent loaded;
+			if (format == 0)
+				loaded.fromJSON(Serialisable::JSON::from<SerialisableInternals::JSONformat>(saved.to<SerialisableInternals::JSONformat>()));
+			else
+				loaded.fromJSON(Serialisable::JSON::from<CondensedJSON>(saved.to<CondensedJSON>()));
+			auto loadedFirst = std::dynamic_pointer_cast<Content1>(loaded.contents.at(0));
+			auto loadedSecond = std::dynamic_pointer_cast<Content2>(loaded.contents.at(1));
+			if (!loadedFirst || loadedFirst->value != "first" || !loadedSecond || loadedSecond->value != 2.5 || !loadedSecond->fullscreen
+					|| !dynamic_cast<Content1*>(loaded.main.get())) {
+				std::cout << "Polymorphic objects were not reloaded in format " << format << std::endl;
+				correct = false;
+			}
+		}
+	}
+
+	// Shared objects are saved once while tracked, cycles are restored
+	{
+		Pair saved;
+		auto first = std::make_shared<Linked>();
+		auto second = std::make_shared<Linked>();
+		first->other = second;
+		second->other = first;
+		second->fullscreen = true;
+		saved.a = first;
+		saved.b = second;
+		SerialisableInternals::SharedObjectTracking tracking;
+		for (int format = 0; format < 2; format++) {
+			Pair loaded;
+			if (format == 0)
+				loaded.fromJSON(Serialisable::JSON::from<SerialisableInternals::JSONformat>(saved.to<SerialisableInternals::JSONformat>()));
+			else
+				loaded.fromJSON(Serialisable::JSON::from<CondensedJSON>(saved.to<CondensedJSON>()));
+			Linked* loadedFirst = dynamic_cast<Linked*>(loaded.a.get());
+			Linked* loadedSecond = dynamic_cast<Linked*>(loaded.b.get());
+			if (!loadedFirst || !loadedSecond || loadedFirst->other != loaded.b || loadedSecond->other != loaded.a || !loadedSecond->fullscreen) {
+				std::cout << "Shared polymorphic objects were not reloaded as shared in format " << format << std::endl;
+				correct = false;
+			}
+			if (loadedFirst)
+				loadedFirst->other = nullptr; // Breaks the cycle, so that the objects are freed
+		}
+		second->other = nullptr;
+	}
+
+	// Objects are created as soon as the type is read from a stream, it doesn't have to be first
+	{
+		std::stringstream stream("{\"type\": \"c1\", \"fullscreen\": true, \"value\": \"streamed\"}\n"
+				"{\"value\": 3.5, \"unknown\": [1, 2], \"type\": \"c2\"}\n"
+				"null\n"
+				"{\"fullscreen\": true}\n");
+		std::unique_ptr<ContentType> loaded;
+		SerialisablePolymorphic::loadFromStream(loaded, stream);
+		Content1* first = dynamic_cast<Content1*>(loaded.get());
+		if (!first || !first->fullscreen || first->value != "streamed") {
+			std::cout << "An object with the type first was not streamed correctly" << std::endl;
+			correct = false;
+		}
+		SerialisablePolymorphic::loadFromStream(loaded, stream);
+		Content2* second = dynamic_cast<Content2*>(loaded.get());
+		if (!second || second->fullscreen || second->value != 3.5) {
+			std::cout << "An object with the type last was not streamed correctly" << std::endl;
+			correct = false;
+		}
+		SerialisablePolymorphic::loadFromStream(loaded, stream);
+		if (loaded) {
+			std::cout << "A null object was not streamed correctly" << std::endl;
+			correct = false;
+		}
+		try {
+			SerialisablePolymorphic::loadFromStream(loaded, stream);
+			std::cout << "An object without type was accepted" << std::endl;
+			correct = false;
+		} catch (Serialisable::SerialisationError&) { }
+	}
+
+	if (correct)
+		std::cout << "Polymorphic objects work correctly" << std::endl;
+	return correct ? 0 : 1;
 }
@@ -10,6 +10,12 @@
 #include <vector>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
+#include <map>
+#include <set>
+#include <deque>
+#include <list>
+#include <tuple>
 #include <fstream>
 #include <memory>
 #include <array>
@@ -20,14 +26,47 @@
 #include <cmath>
 #include <algorithm>
 #include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <ctime>
+#include <typeinfo>
+#include <typeindex>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <limits>
+#include <chrono>
+#if defined(__GNUC__)
+#include <cxxabi.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#define SERIALISABLE_BY_DUGI_POSIX_FILES
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #if __cplusplus > 201402L
 #include <optional>
+#include <variant>
+#include <charconv>
 #endif
 
 class Serialisable;
 
 namespace SerialisableInternals {
 
+class StringInterner;
+class SharedObjectTracking;
+
+// Marks a serialisation or deserialisation of an object, so that the shared objects' identifiers start again with the outermost one
+class SharedObjectDocument {
+	SharedObjectTracking* _tracking;
+public:
+	inline SharedObjectDocument();
+	inline ~SharedObjectDocument();
+	SharedObjectDocument(const SharedObjectDocument&) = delete;
+};
+
 template <typename Serialised, typename SFINAE>
 struct Serialiser {
 	constexpr static bool valid = false;
@@ -36,30 +75,344 @@ struct Serialiser {
 template <typename Returned, typename ArgType>
 auto getArgType(Returned (*)(ArgType)) { return *reinterpret_cast<std::decay_t<ArgType>*>(1); }
 
+// A flag enabling recording of time spent in serialisation, encoding and file access, exportable in Chrome's trace event format
+// It has to be started at runtime as well, if it's not defined, the tracing code is not compiled at all
+// #define SERIALISABLE_BY_DUGI_TRACE
+
+// Records spans of time per thread, start() and stop() control whether anything is recorded
+class Tracing {
+	struct Event {
+		std::string name;
+		const char* category;
+		int64_t start;
+		int64_t duration;
+	};
+	struct ThreadEvents {
+		std::mutex lock; // Uncontended, unless the events are exported while recording
+		std::vector<Event> events;
+		int thread;
+	};
+	struct Registry {
+		std::mutex lock;
+		std::vector<std::shared_ptr<ThreadEvents>> threads;
+		std::atomic<bool> enabled = { false };
+		std::atomic<int64_t> start = { 0 }; // Nanoseconds of the steady clock, atomic because spans read it while tracing is restarted
+	};
+	static Registry& registry() {
+		static Registry instance;
+		return instance;
+	}
+	static ThreadEvents& local() {
+		thread_local std::shared_ptr<ThreadEvents> instance = [] {
+			Registry& shared = registry();
+			std::lock_guard<std::mutex> lock(shared.lock);
+			auto made = std::make_shared<ThreadEvents>();
+			made->thread = int(shared.threads.size()) + 1;
+			shared.threads.push_back(made);
+			return made;
+		}();
+		return *instance;
+	}
+	static int64_t ticks() {
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+	static int64_t now() {
+		return ticks() - registry().start.load(std::memory_order_relaxed);
+	}
+	// Set while the thread saves the recorded spans, so that the export doesn't trace itself
+	static bool& exporting() {
+		thread_local bool instance = false;
+		return instance;
+	}
+
+public:
+	static void start() {
+		registry().start.store(ticks(), std::memory_order_relaxed);
+		registry().enabled.store(true, std::memory_order_release); // Spans that see it enabled see the new start as well
+	}
+	static void stop() {
+		registry().enabled = false;
+	}
+	static bool enabled() {
+		return registry().enabled.load(std::memory_order_acquire);
+	}
+	static void clear() {
+		Registry& shared = registry();
+		std::lock_guard<std::mutex> lock(shared.lock);
+		for (auto& it : shared.threads) {
+			std::lock_guard<std::mutex> threadLock(it->lock);
+			it->events.clear();
+		}
+	}
+
+	/*!
+	* \brief Writes the recorded spans in Chrome's trace event format, viewable in chrome://tracing or Perfetto
+	* \param The name of the file
+	*/
+	inline static void save(const std::string& fileName);
+
+	static std::string typeName(const std::type_info& type) {
+		thread_local std::unordered_map<std::type_index, std::string> names;
+		auto found = names.find(type);
+		if (found != names.end())
+			return found->second;
+		std::string name = type.name();
+#if defined(__GNUC__)
+		int status = 0;
+		char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+		if (demangled) {
+			name = demangled;
+			free(demangled);
+		}
+#endif
+		return names[type] = name;
+	}
+
+	// Records the time from its construction to its destruction, if tracing was enabled at construction
+	class Span {
+		std::string _name;
+		const char* _category = nullptr;
+		int64_t _start = 0;
+	public:
+		template <typename NameMaker>
+		Span(const char* category, NameMaker makeName) {
+			if (!enabled() || exporting())
+				return;
+			_name = makeName();
+			_category = category;
+			_start = now();
+		}
+		Span(const Span&) = delete;
+		~Span() {
+			if (!_category)
+				return;
+			int64_t end = now();
+			ThreadEvents& events = local();
+			std::lock_guard<std::mutex> lock(events.lock);
+			events.events.push_back({ std::move(_name), _category, _start, end - _start });
+		}
+	};
+};
+
+#ifdef SERIALISABLE_BY_DUGI_TRACE
+#define SERIALISABLE_BY_DUGI_TRACE_CONCATENATE_INNER(FIRST, SECOND) FIRST ## SECOND
+#define SERIALISABLE_BY_DUGI_TRACE_CONCATENATE(FIRST, SECOND) SERIALISABLE_BY_DUGI_TRACE_CONCATENATE_INNER(FIRST, SECOND)
+#define SERIALISABLE_BY_DUGI_TRACE_SPAN(CATEGORY, NAME) \
+	SerialisableInternals::Tracing::Span SERIALISABLE_BY_DUGI_TRACE_CONCATENATE(tracingSpan, __LINE__)(CATEGORY, [&] () -> std::string { return NAME; })
+#else
+#define SERIALISABLE_BY_DUGI_TRACE_SPAN(CATEGORY, NAME)
+#endif
+
+// Formats that aren't text can set constexpr static bool binary = true to let serialisers use representations that
+// would be inconvenient in text, but translate to less markup in binary, such as maps with numeric keys
+template <typename Format, typename SFINAE = void>
+struct IsBinaryFormat : std::false_type { };
+
+template <typename Format>
+struct IsBinaryFormat<Format, std::enable_if_t<Format::binary>> : std::true_type { };
+
+// Tells serialisers whether the JSON being made is going to be written in a binary format
+struct BinaryTarget {
+	static bool& active() {
+		thread_local bool binary = false;
+		return binary;
+	}
+
+	// Sets the target while it exists
+	class Scope {
+		bool _previous;
+	public:
+		Scope(bool binary) : _previous(active()) {
+			active() = binary;
+		}
+		Scope(const Scope&) = delete;
+		~Scope() {
+			active() = _previous;
+		}
+	};
+};
+
+// Lets a serialisation running in slices pause before serialising each object, see serialisable_sliced.hpp
+struct Checkpoint {
+	using Hook = void (*)(void* context);
+	struct Active {
+		Hook hook = nullptr;
+		void* context = nullptr;
+	};
+
+	static Active& active() {
+		thread_local Active instance;
+		return instance;
+	}
+
+	// The hook may throw to abandon the serialisation
+	static void reached() {
+		Active& current = active();
+		if (current.hook)
+			current.hook(current.context);
+	}
+};
+
+// Saves and loads files in a format, specialised for formats that read or write streams
 template <typename Format, typename SFINAE>
-struct DiskAccessor {
-	template <typename Internal>
-	static void save(const std::string& fileName, const Internal& source) {
-		auto serialised = Format::serialise(source);
-		std::ofstream stream(fileName, std::ios::binary);
-		for (auto& it : serialised)
-			stream << it;
+struct DiskAccessor;
+
+// A flag disabling the slab allocator for JSON's heap nodes, they will be allocated with new instead
+// #define SERIALISABLE_BY_DUGI_NO_SLAB_ALLOCATOR
+
+// Allocates JSON's heap nodes from slabs split into blocks of a few sizes, freed blocks are kept in thread-local lists for reuse
+class NodeAllocator {
+	constexpr static int GRANULARITY = 16; // Also the alignment
+	constexpr static int SIZE_CLASSES = 16; // Blocks of up to 256 bytes, larger ones are allocated with new
+	constexpr static int SLAB_SIZE = 16384;
+	constexpr static int LOCAL_LIMIT = 4 * SLAB_SIZE; // Bytes of one size class a thread may keep, the rest goes to the pool
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+	using FreeLists = std::array<FreeBlock*, SIZE_CLASSES>;
+	using Counts = std::array<size_t, SIZE_CLASSES>;
+
+	// Blocks from threads that have ended or that freed more than they allocate
+	struct Pool {
+		std::mutex lock;
+		FreeLists lists = {};
+		Counts counts = {};
+		std::atomic<bool> empty = { true };
+	};
+	static Pool& pool() {
+		static Pool* instance = new Pool(); // Never destroyed, some nodes may be freed during destruction of static objects
+		return *instance;
 	}
 
-	template <typename Internal>
-	static Internal load(const std::string& fileName) {
-		std::decay_t<decltype(getArgType(&Format::deserialise))> making;
-		Internal made;
-		std::ifstream stream(fileName, std::ios::binary);
-		stream >> std::noskipws;
-		while (stream.good()) {
-			std::decay_t<decltype(making.front())> reading;
-			stream >> reading;
-			making.push_back(reading);
+	struct Local {
+		FreeLists lists = {};
+		Counts counts = {};
+		~Local() {
+			Pool& shared = pool();
+			std::lock_guard<std::mutex> lock(shared.lock);
+			for (int i = 0; i < SIZE_CLASSES; i++) {
+				shared.lists[i] = join(lists[i], shared.lists[i]);
+				shared.counts[i] += counts[i];
+			}
+			shared.empty = false;
+			destroyed() = true;
 		}
-		return Format::deserialise(making);
+	};
+	static bool& destroyed() {
+		thread_local bool instance = false; // Trivially destructible, so it can be checked after Local is destroyed
+		return instance;
+	}
+	static Local& local() {
+		thread_local Local instance;
+		return instance;
+	}
+
+	static FreeBlock* join(FreeBlock* first, FreeBlock* second) {
+		if (!first)
+			return second;
+		FreeBlock* last = first;
+		while (last->next)
+			last = last->next;
+		last->next = second;
+		return first;
+	}
+
+	static FreeBlock* refill(int sizeClass, size_t& count) {
+		Pool& shared = pool();
+		if (!shared.empty) {
+			std::lock_guard<std::mutex> lock(shared.lock);
+			FreeBlock* taken = shared.lists[sizeClass];
+			count = shared.counts[sizeClass];
+			shared.lists[sizeClass] = nullptr;
+			shared.counts[sizeClass] = 0;
+			shared.empty = std::all_of(shared.lists.begin(), shared.lists.end(), [] (FreeBlock* list) { return !list; });
+			if (taken)
+				return taken;
+		}
+		const int blockSize = (sizeClass + 1) * GRANULARITY;
+		uint8_t* slab = static_cast<uint8_t*>(::operator new(SLAB_SIZE)); // Slabs are kept for reuse until the program ends
+		FreeBlock* made = nullptr;
+		count = 0;
+		for (int offset = SLAB_SIZE - blockSize; offset >= 0; offset -= blockSize) {
+			FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + offset);
+			block->next = made;
+			made = block;
+			count++;
+		}
+		return made;
+	}
+
+	// A thread that only frees blocks allocated by others would collect them all, so it keeps the recently freed half and gives the rest away
+	static void donate(int sizeClass, Local& owner) {
+		size_t kept = owner.counts[sizeClass] / 2;
+		FreeBlock* last = owner.lists[sizeClass];
+		for (size_t i = 1; i < kept; i++)
+			last = last->next;
+		FreeBlock* given = last->next;
+		last->next = nullptr;
+		Pool& shared = pool();
+		std::lock_guard<std::mutex> lock(shared.lock);
+		shared.lists[sizeClass] = join(given, shared.lists[sizeClass]);
+		shared.counts[sizeClass] += owner.counts[sizeClass] - kept;
+		shared.empty = false;
+		owner.counts[sizeClass] = kept;
+	}
+
+public:
+	// Held around fork(), so that the child doesn't inherit the pool locked by a thread that doesn't exist there
+	static void lockForFork() {
+		pool().lock.lock();
+	}
+	static void unlockAfterFork() {
+		pool().lock.unlock();
+	}
+
+	static size_t blockSize(size_t size) {
+		return (size + GRANULARITY - 1) / GRANULARITY * GRANULARITY;
+	}
+
+	static void* allocate(size_t size) {
+		const int sizeClass = int((size + GRANULARITY - 1) / GRANULARITY) - 1;
+		if (sizeClass >= SIZE_CLASSES)
+			return ::operator new(size);
+		if (destroyed())
+			return ::operator new(blockSize(size)); // Will be released into the pool as a block of its size class
+		Local& owner = local();
+		FreeBlock*& list = owner.lists[sizeClass];
+		if (!list)
+			list = refill(sizeClass, owner.counts[sizeClass]);
+		FreeBlock* taken = list;
+		list = taken->next;
+		owner.counts[sizeClass]--;
+		return taken;
+	}
+
+	static void release(void* block, size_t size) {
+		const int sizeClass = int((size + GRANULARITY - 1) / GRANULARITY) - 1;
+		if (sizeClass >= SIZE_CLASSES) {
+			::operator delete(block);
+			return;
+		}
+		FreeBlock* freed = static_cast<FreeBlock*>(block);
+		if (destroyed()) {
+			Pool& shared = pool();
+			std::lock_guard<std::mutex> lock(shared.lock);
+			freed->next = shared.lists[sizeClass];
+			shared.lists[sizeClass] = freed;
+			shared.counts[sizeClass]++;
+			shared.empty = false;
+			return;
+		}
+		Local& owner = local();
+		FreeBlock*& list = owner.lists[sizeClass];
+		freed->next = list;
+		list = freed;
+		if (++owner.counts[sizeClass] * (sizeClass + 1) * GRANULARITY > LOCAL_LIMIT)
+			donate(sizeClass, owner);
 	}
 };
+
 } // namespace
 
 struct ISerialisable {
@@ -88,8 +441,9 @@ struct ISerialisable {
 		private:
 			constexpr static int BREAKPOINT = 8;
 			using RefcountType = int32_t;
+			using HashType = uint32_t;
 			using CharType = int8_t;
-			constexpr static int INTERNAL_OFFSET = sizeof(RefcountType);
+			constexpr static int INTERNAL_OFFSET = sizeof(HashType) + sizeof(RefcountType); // Hash is first, refcount is right before the text
 
 			uint64_t _contents;
 			CharType* longContents;
@@ -112,7 +466,7 @@ struct ISerialisable {
 					return reinterpret_cast<T*>((_contents | 0xffff000000000000) + uint64_t(offset));
 			}
 			RefcountType& refcount() {
-				return *memory<RefcountType>(-INTERNAL_OFFSET);
+				return *memory<RefcountType>(-int(sizeof(RefcountType)));
 			}
 			void unref() {
 				if (isLocal())
@@ -123,7 +477,8 @@ struct ISerialisable {
 			}
 			void makeHeap(size_t size, const char* data) {
 				CharType* remote = new CharType[INTERNAL_OFFSET + size + 1];
-				*reinterpret_cast<RefcountType*>(remote) = 1;
+				*reinterpret_cast<HashType*>(remote) = 0; // Not computed yet
+				*reinterpret_cast<RefcountType*>(remote + sizeof(HashType)) = 1;
 				memcpy(INTERNAL_OFFSET + remote, data, size + 1);
 				_contents = reinterpret_cast<uint64_t>(remote + INTERNAL_OFFSET) & 0x0000ffffffffffff;
 			}
@@ -174,6 +529,18 @@ struct ISerialisable {
 				}
 				return result;
 			}
+			// Copies the text into an existing string, reusing its capacity
+			void copyTo(std::string& target) const {
+				target.clear();
+				if (isLocal()) {
+					for (int i = 56; i >= 0; i -= 8) {
+						CharType at = CharType(_contents >> i);
+						if (!at) break;
+						target.push_back(at);
+					}
+				} else
+					target.append(reinterpret_cast<const char*>(memory<CharType>(0)));
+			}
 			String& operator=(const String& from) {
 				unref();
 				_contents = from._contents;
@@ -199,10 +566,13 @@ struct ISerialisable {
 			bool operator==(const char* other) const {
 				if (isLocal()) {
 					for (int i = 0; i < int(sizeof(uint64_t)); i++) {
-						if (CharType((_contents & maskOfCharacter(i)) >> (i << 3)) != other[i])
+						CharType at = CharType(_contents >> offsetOfCharacter(i));
+						if (at != other[i])
 							return false;
+						if (!at)
+							return true;
 					}
-					return true;
+					return !other[sizeof(uint64_t)];
 				} else {
 					return !strcmp(memory<char>(0), other);
 				}
@@ -216,16 +586,29 @@ struct ISerialisable {
 					std::hash<uint64_t> hasher;
 					return hasher(_contents);
 				} else {
-					// FNV hash
+					// FNV hash, kept in the shared buffer so that copies of the same key don't compute it again
+					HashType& cached = *memory<HashType>(-INTERNAL_OFFSET);
+					if (cached)
+						return cached;
 					char* data = memory<char>(0);
 					const static unsigned int startValue = 2166136261 ^ time(nullptr);
 					unsigned int value = startValue;
 					for (int i = 0; data[i]; i++)
 						value = (value * 16777619) ^ data[i];
+					if (!value)
+						value = 1; // Zero means it wasn't computed
+					cached = value;
 					return value;
 				}
 			}
 
+			// Size of the allocated buffer, 0 if it's stored locally or was already counted
+			size_t heapSize(std::unordered_set<const void*>& counted) const {
+				if (isLocal() || !counted.insert(memory<void>(0)).second)
+					return 0;
+				return INTERNAL_OFFSET + strlen(memory<char>(0)) + 1;
+			}
+
 			friend std::ostream& operator<<(std::ostream& stream , const String& str);
 		};
 
@@ -246,6 +629,8 @@ struct ISerialisable {
 		static constexpr uint64_t INVALID_NUMBER_IDENTIFIER = 0xfff8000000000000;
 		static constexpr uint64_t NAN_VALUE = 0x7fffffffffffffff;
 		using RefcountType = int;
+		using SizeType = uint32_t;
+		static constexpr int HEADER_SIZE = 16; // Keeps the contents aligned to 16 bytes, starts with the leading key, ends with size and refcount
 		static constexpr uint64_t POINTER_MASK = 0x0000ffffffffffff;
 		static constexpr int STRING_BREAKPOINT = 6;
 		struct InternalType {
@@ -287,11 +672,21 @@ struct ISerialisable {
 		}
 		template<typename T>
 		T* allocate(int size) {
-			uint8_t* allocated = new uint8_t[sizeof(RefcountType) + unsigned(size)];
-			*reinterpret_cast<RefcountType*>(allocated) = 1;
-			_contents = reinterpret_cast<uint64_t>(allocated + sizeof(RefcountType));
+			const size_t total = HEADER_SIZE + unsigned(size);
+#ifdef SERIALISABLE_BY_DUGI_NO_SLAB_ALLOCATOR
+			uint8_t* allocated = static_cast<uint8_t*>(::operator new(total));
+#else
+			uint8_t* allocated = static_cast<uint8_t*>(SerialisableInternals::NodeAllocator::allocate(total));
+#endif
+			*reinterpret_cast<const char**>(allocated) = nullptr;
+			*reinterpret_cast<SizeType*>(allocated + HEADER_SIZE - sizeof(RefcountType) - sizeof(SizeType)) = SizeType(total);
+			*reinterpret_cast<RefcountType*>(allocated + HEADER_SIZE - sizeof(RefcountType)) = 1;
+			_contents = reinterpret_cast<uint64_t>(allocated + HEADER_SIZE);
 			return reinterpret_cast<T*>(_contents);
 		}
+		inline SizeType allocatedSize() const {
+			return *reinterpret_cast<const SizeType*>(internalAddress() - sizeof(RefcountType) - sizeof(SizeType));
+		}
 		inline void cleanup() {
 			if (!usesHeap()) return;
 			RefcountType& refs = refcount();
@@ -303,7 +698,11 @@ struct ISerialisable {
 					reinterpret_cast<ObjectType*>(suffix)->~unordered_map();
 				else if (prefix == InternalType::ARRAY)
 					reinterpret_cast<ArrayType*>(suffix)->~vector();
-				delete[] reinterpret_cast<char*>(suffix - sizeof(RefcountType));
+#ifdef SERIALISABLE_BY_DUGI_NO_SLAB_ALLOCATOR
+				::operator delete(reinterpret_cast<uint8_t*>(suffix - HEADER_SIZE));
+#else
+				SerialisableInternals::NodeAllocator::release(reinterpret_cast<uint8_t*>(suffix - HEADER_SIZE), allocatedSize());
+#endif
 			}
 		}
 
@@ -450,6 +849,31 @@ struct ISerialisable {
 		bool isString() const {
 			return ((_contents & TYPE_MASK) == InternalType::SHORT_STRING || (_contents & TYPE_MASK) == InternalType::LONG_STRING);
 		}
+		using ShortStringBuffer = std::array<char, STRING_BREAKPOINT + 1>;
+		/*!
+		* \brief Accesses the string's text without allocating
+		* \param Buffer that short strings are copied into, the result is valid while both it and the JSON exist
+		* \param Set to the length of the string
+		* \return The zero-terminated text
+		* \throw If it's not a string
+		*/
+		const char* stringData(ShortStringBuffer& buffer, size_t& length) const {
+			if ((_contents & TYPE_MASK) == InternalType::SHORT_STRING) {
+				length = 0;
+				for ( ; length < size_t(STRING_BREAKPOINT); length++) {
+					buffer[length] = char(_contents >> (length << 3));
+					if (!buffer[length])
+						break;
+				}
+				buffer[length] = '\0';
+				return buffer.data();
+			} else if ((_contents & TYPE_MASK) == InternalType::LONG_STRING) {
+				const char* text = getHeap<char>();
+				length = strlen(text);
+				return text;
+			} else
+				throw JSONexception("Value is not really a string");
+		}
 		std::string string() const {
 			if ((_contents & TYPE_MASK) == InternalType::SHORT_STRING) {
 				std::string result;
@@ -511,6 +935,18 @@ struct ISerialisable {
 			cleanup();
 			setObject(value);
 		}
+		// Makes writers put this member of the object first, so that readers learn it before the rest, the name must outlive the JSON
+		void leadWith(const char* key) {
+			if ((_contents & TYPE_MASK) != InternalType::OBJECT)
+				throw JSONexception("Value is not really an object");
+			*reinterpret_cast<const char**>(internalAddress() - HEADER_SIZE) = key;
+		}
+		// The member writers put first, nullptr if any order will do
+		const char* leadingMember() const {
+			if ((_contents & TYPE_MASK) != InternalType::OBJECT)
+				return nullptr;
+			return *reinterpret_cast<const char* const*>(internalAddress() - HEADER_SIZE);
+		}
 		const ObjectType& operator=(const ObjectType& value) {
 			setObject(value);
 			return value;
@@ -620,13 +1056,22 @@ struct ISerialisable {
 
 		template <typename Format>
 		auto to() const {
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("encode", SerialisableInternals::Tracing::typeName(typeid(Format)) + "::serialise");
 			return Format::serialise(*this);
 		}
 
+		// Appends to a buffer owned by the caller, so that its capacity can be reused, the format must have serialiseInto()
+		template <typename Format, typename Output>
+		void to(Output& output) const {
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("encode", SerialisableInternals::Tracing::typeName(typeid(Format)) + "::serialiseInto");
+			Format::serialiseInto(*this, output);
+		}
+
 		template <typename Format, typename SourceType>
 		static JSON from(const SourceType& source) {
 			static_assert (std::is_same<std::decay_t<decltype(Format::deserialise(SourceType()))>, JSON>::value,
 					"Format object does not take the given type as argument to deserialise");
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("decode", SerialisableInternals::Tracing::typeName(typeid(Format)) + "::deserialise");
 			return Format::deserialise(source);
 		}
 
@@ -645,7 +1090,74 @@ struct ISerialisable {
 		inline void save(const std::string& fileName) const;
 		inline static JSON load(const std::string& fileName);
 
+		struct MemoryUsage {
+			size_t strings = 0; // Strings too long to be stored locally, including keys
+			size_t objects = 0; // Hashtables, their buckets and nodes
+			size_t arrays = 0; // Arrays and their used capacity
+			size_t slack = 0; // Unused capacity of arrays and unused parts of allocated blocks
+
+			size_t total() const {
+				return strings + objects + arrays + slack;
+			}
+			MemoryUsage& operator+=(const MemoryUsage& other) {
+				strings += other.strings;
+				objects += other.objects;
+				arrays += other.arrays;
+				slack += other.slack;
+				return *this;
+			}
+		};
+
+		/*!
+		* \brief Computes how much heap memory is used by the value and everything it contains
+		* \return The memory used, by category
+		*
+		* \note Shared strings and subtrees are counted only once
+		* \note The size of hashtable nodes is estimated for common implementations of the standard library
+		*/
+		MemoryUsage memoryUsage() const {
+			MemoryUsage usage;
+			std::unordered_set<const void*> counted;
+			addMemoryUsage(usage, counted);
+			return usage;
+		}
+
 		friend std::ostream& operator<<(std::ostream& stream , const JSON& json);
+		friend class SerialisableInternals::StringInterner;
+
+	private:
+		void addMemoryUsage(MemoryUsage& usage, std::unordered_set<const void*>& counted) const {
+			if (!usesHeap() || !counted.insert(getHeap<void>()).second)
+				return;
+			size_t allocated = allocatedSize();
+#ifndef SERIALISABLE_BY_DUGI_NO_SLAB_ALLOCATOR
+			usage.slack += SerialisableInternals::NodeAllocator::blockSize(allocated) - allocated;
+#endif
+			switch (_contents & TYPE_MASK) {
+			case InternalType::LONG_STRING:
+				usage.strings += allocated;
+				break;
+			case InternalType::OBJECT: {
+				const ObjectType& object = *getHeap<ObjectType>();
+				// Each node holds a pointer to the next one, the key, the value and the cached hash
+				constexpr size_t nodeSize = sizeof(void*) + sizeof(ObjectType::value_type) + sizeof(size_t);
+				usage.objects += allocated + object.bucket_count() * sizeof(void*) + object.size() * nodeSize;
+				for (auto& it : object) {
+					usage.strings += it.first.heapSize(counted);
+					it.second.addMemoryUsage(usage, counted);
+				}
+				break;
+			}
+			case InternalType::ARRAY: {
+				const ArrayType& array = *getHeap<ArrayType>();
+				usage.arrays += allocated + array.size() * sizeof(JSON);
+				usage.slack += (array.capacity() - array.size()) * sizeof(JSON);
+				for (auto& it : array)
+					it.addMemoryUsage(usage, counted);
+				break;
+			}
+			}
+		}
 	};
 
 	virtual JSON toJSON() const = 0;
@@ -662,9 +1174,24 @@ struct ISerialisable {
 	*/
 	template <typename Format>
 	auto to() const {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
 		return toJSON().to<Format>();
 	}
 
+	/*!
+	* \brief Serialises the object as a custom type into a buffer owned by the caller
+	* \tparam A class with a static method serialiseInto(JSON, Output&)
+	* \param The buffer, the result is appended to it, so it can be cleared and reused to avoid allocations
+	*
+	* \note It calls the overloaded serialisation() method
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	template <typename Format, typename Output>
+	void to(Output& output) const {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		toJSON().to<Format>(output);
+	}
+
 	/*!
 	* \brief Deserialises the object from a custom type
 	* \tparam A class with a static method deserialise() that returns JSON
@@ -705,12 +1232,14 @@ struct ISerialisable {
 	* \brief Saves the object to a custom format file
 	* \tparam The format
 	* \param The name of the file
+	* \throw If the file cannot be written
 	*
 	* \note It calls the overloaded serialisation() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	template <typename Format>
 	void saveAs(const std::string& fileName) const {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
 		toJSON().saveAs<Format>(fileName);
 	}
 
@@ -731,17 +1260,21 @@ struct ISerialisable {
 	* \brief Loads the object from a JSON file
 	* \param The name of the JSON file
 	*
+	* \throw If reading the file fails after opening it, or if it's invalid
+	*
 	* \note It calls the overloaded serialisation() method
-	* \note If the file cannot be read, nothing is done
+	* \note If the file cannot be opened, nothing is done
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline void load(const std::string& fileName) {
-		fromJSON(JSON::load(fileName));
+		if (std::ifstream(fileName).is_open()) // Loading the JSON itself reports it as an error
+			fromJSON(JSON::load(fileName));
 	}
 
 	/*!
 	* \brief Saves the object to a JSON file
 	* \param The name of the JSON file
+	* \throw If the file cannot be written
 	*
 	* \note It calls the overloaded serialisation() method
 	* \note Not only that it's not thread-safe, it's not even reentrant
@@ -749,6 +1282,23 @@ struct ISerialisable {
 	inline void save(const std::string& fileName) const {
 		toJSON().save(fileName);
 	}
+
+	/*!
+	* \brief Computes the memory used by the serialised form of each member
+	* \return The memory used by the JSON of each key
+	*
+	* \note It calls the overloaded serialisation() method
+	* \note A subtree shared by several members is counted in each of them
+	*/
+	std::unordered_map<std::string, JSON::MemoryUsage> memoryUsageByKey() const {
+		std::unordered_map<std::string, JSON::MemoryUsage> result;
+		JSON serialised = toJSON();
+		if (!serialised.isObject())
+			return result;
+		for (auto& it : serialised.object())
+			result[it.first] = it.second.memoryUsage();
+		return result;
+	}
 };
 
 class Serialisable : public ISerialisable {
@@ -758,6 +1308,7 @@ public:
 	using SerialisationError = ISerialisable::SerialisationError;
 	using JSONtype = ISerialisable::JSONtype;
 	using JSON = ISerialisable::JSON;
+	using Tracing = SerialisableInternals::Tracing;
 
 private:
 	static const char* base64chars() {
@@ -823,13 +1374,105 @@ public:
 		return result;
 	}
 
+	/*!
+	* \brief The keys a class synchronises, in the order of the synch() calls, along with the types of the values
+	*
+	* \note It's learned by calling serialisation() in a mode where synch() only records the keys
+	*/
+	struct Schema {
+		struct Field {
+			std::string name;
+			JSON::String key; // Shared by all serialised instances, so its hash is computed only once
+			const std::type_info* type;
+		};
+		std::vector<Field> fields;
+
+		size_t size() const {
+			return fields.size();
+		}
+	};
+
+	/*!
+	* \brief Supplies the members of an object one by one, in the order they are stored, so that they can be loaded without parsing the whole object first
+	*
+	* \note The value of each member must be read before the name of the next one
+	*/
+	class MemberSource {
+	public:
+		// Reads the name of the next member, returns false if there are no more
+		virtual bool nextName(std::string& name) = 0;
+		// Parses the value of the member whose name was read last
+		virtual JSON value() = 0;
+	protected:
+		~MemberSource() = default;
+	};
+
 private:
 	struct State {
 		JSON _json;
 		bool _saving;
+		Schema* _recording = nullptr;
+		const Schema* _schema = nullptr;
+		unsigned int _field = 0;
+		MemberSource* _source = nullptr; // Members not read yet when loading from a source, nullptr if there are no more
+		JSON _streamed; // The last member read from the source, if it was asked for right away
+		std::string _name;
+
+		JSON::String key(const std::string& name) {
+			if (_schema) {
+				// The key usually is the next one, if it isn't, some keys were skipped
+				for (unsigned int i = _field; i < _schema->fields.size(); i++) {
+					if (_schema->fields[i].name == name) {
+						_field = i + 1;
+						return _schema->fields[i].key;
+					}
+				}
+			}
+			return name;
+		}
+
+		// Finds a member being loaded, if it wasn't read yet, members are read from the source until it's found, those skipped are stored
+		const JSON* loaded(const std::string& name) {
+			JSON::ObjectType& object = _json.object();
+			auto found = object.find(name);
+			if (found != object.end())
+				return &found->second;
+			while (_source) {
+				if (!_source->nextName(_name)) {
+					_source = nullptr;
+					break;
+				}
+				if (_name == name) {
+					_streamed = _source->value();
+					return &_streamed;
+				}
+				object[_name] = _source->value();
+			}
+			return nullptr;
+		}
 	};
 	mutable State* _state = nullptr; // Last variable MUST BE aligned to word size, otherwise SerialisableBrief won't work
 
+	static std::unordered_map<std::type_index, Schema>& schemas() {
+		thread_local std::unordered_map<std::type_index, Schema> instance; // Per thread, because the keys' refcounts aren't atomic
+		return instance;
+	}
+
+	const Schema& recordSchema(const std::type_info& type) const {
+		auto& known = schemas();
+		auto found = known.find(type);
+		if (found != known.end())
+			return found->second;
+		Schema made;
+		State state;
+		state._saving = true;
+		state._recording = &made;
+		_state = &state;
+		const_cast<Serialisable*>(this)->serialisation();
+		_state = nullptr;
+		return known.emplace(type, std::move(made)).first->second;
+	}
+
 protected:
 	/*!
 	* \brief Should all the synch() method on all members that are to be saved
@@ -861,31 +1504,70 @@ protected:
 	inline bool synch(const std::string& key, T& value) {
 		static_assert(SerialisableInternals::Serialiser<T, void>::valid,
 				"Trying to serialise a non-serialisable type");
-		JSON::ObjectType& object = _state->_json.object();
+		if (_state->_recording) {
+			_state->_recording->fields.push_back({ key, key, &typeid(T) });
+			return true;
+		}
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("serialisation", Tracing::typeName(typeid(*this)) + "::" + key);
 		if (_state->_saving) {
-			object[key] = SerialisableInternals::Serialiser<T, void>::serialise(value);
+			_state->_json.object()[_state->key(key)] = SerialisableInternals::Serialiser<T, void>::serialise(value);
 		} else {
-			auto found = object.find(key);
-			if (found != object.end()) {
-				SerialisableInternals::Serialiser<T, void>::deserialise(value, found->second);
+			const JSON* found = _state->loaded(key);
+			if (found) {
+				SerialisableInternals::Serialiser<T, void>::deserialise(value, *found);
 			} else return false;
 		}
 		return true;
 	}
 
+	/*!
+	* \brief Makes writers put a member first when saving, so that readers learn it before the others
+	* \param The key of the member, it must be a constant that is never deallocated
+	*
+	* \note Meaningless outside a serialisation() overload, ignored when loading
+	*/
+	inline void leadWith(const char* key) {
+		if (_state->_saving && !_state->_recording)
+			_state->_json.leadWith(key);
+	}
+
 public:
 
+	/*!
+	* \brief Returns the schema of a class, learned from a default-constructed instance
+	* \tparam The class, must be default constructible
+	* \return The schema, cached for each thread
+	*
+	* \note It calls the overloaded serialisation() method, but synch() doesn't access the values
+	*/
+	template <typename T>
+	static const Schema& schema() {
+		static_assert(std::is_base_of<Serialisable, T>::value, "Only classes derived from Serialisable have a schema");
+		auto& known = schemas();
+		auto found = known.find(typeid(T));
+		if (found != known.end())
+			return found->second;
+		T instance;
+		return static_cast<const Serialisable&>(instance).recordSchema(typeid(T));
+	}
+
 	/*!
 	* \brief Serialises the object to JSON
 	* \return The JSON
 	*
 	* \note It calls the overloaded serialisation() method
+	* \note The first call for a class learns its schema from this instance (without accessing the values)
 	* \note Not only that it's not thread-safe, it's not even reentrant
 	*/
 	inline JSON toJSON() const override {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("serialisation", Tracing::typeName(typeid(*this)) + "::toJSON");
+		SerialisableInternals::Checkpoint::reached();
+		SerialisableInternals::SharedObjectDocument document;
+		const Schema& schema = recordSchema(typeid(*this));
 		State state;
-		state._json.setObject();
+		state._json.setObject().reserve(schema.size());
 		state._saving = true;
+		state._schema = &schema;
 		_state = &state;
 		const_cast<Serialisable*>(this)->serialisation();
 		_state = nullptr;
@@ -908,6 +1590,8 @@ public:
 		}
 		if (type != JSON::Type::OBJECT)
 			throw SerialisationError("Deserialising JSON from a wrong type");
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("serialisation", Tracing::typeName(typeid(*this)) + "::fromJSON");
+		SerialisableInternals::SharedObjectDocument document;
 		State state;
 		state._json = source;
 		state._saving = false;
@@ -915,6 +1599,29 @@ public:
 		serialisation();
 		_state = nullptr;
 	}
+
+	/*!
+	* \brief Loads the object from members read one by one, without parsing the whole object first
+	* \param The source of the members, it's read until its end
+	*
+	* \note It calls the overloaded serialisation() method, a member asked for is read right away if it's the next one in the source,
+	* the members before it are parsed and kept until they are asked for
+	* \note Not only that it's not thread-safe, it's not even reentrant
+	*/
+	inline void fromMembers(MemberSource& source) {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("serialisation", Tracing::typeName(typeid(*this)) + "::fromMembers");
+		SerialisableInternals::SharedObjectDocument document;
+		State state;
+		state._json.setObject();
+		state._saving = false;
+		state._source = &source;
+		_state = &state;
+		serialisation();
+		_state = nullptr;
+		if (state._source)
+			while (source.nextName(state._name))
+				source.value(); // Unknown members are skipped
+	}
 };
 
 inline std::ostream& operator<<(std::ostream& stream , const Serialisable::JSON::String& str) {
@@ -968,59 +1675,590 @@ inline std::ostream& operator<<(std::ostream& stream , const Serialisable::JSON&
 
 namespace SerialisableInternals {
 
-struct JSONformat {
-	static std::string serialise(const Serialisable::JSON& serialised)  {
-		std::stringstream stream;
-		toStream(serialised, stream, 0);
-		return stream.str();
+/*!
+* \brief While it exists, strings parsed by the current thread share their memory with identical previously parsed strings
+*
+* \note Only strings too long to be stored inside the JSON object itself are interned
+* \note Interned strings are kept alive by the table until it's destroyed
+*/
+class StringInterner {
+	struct View {
+		const char* data;
+		size_t length;
+		bool operator==(const View& other) const {
+			return length == other.length && !memcmp(data, other.data, length);
+		}
+	};
+	struct ViewHasher {
+		size_t operator()(const View& view) const {
+			uint64_t value = 14695981039346656037ull; // FNV-1a
+			for (size_t i = 0; i < view.length; i++)
+				value = (value ^ uint8_t(view.data[i])) * 1099511628211ull;
+			return size_t(value);
+		}
+	};
+	std::unordered_map<View, Serialisable::JSON, ViewHasher> _strings; // Views point into the stored strings
+	size_t _capacity;
+	size_t _hits = 0;
+	size_t _bytesSaved = 0;
+	StringInterner* _previous;
+
+	static StringInterner*& current() {
+		thread_local StringInterner* instance = nullptr;
+		return instance;
 	}
 
-	static Serialisable::JSON deserialise(const std::string& source) {
-		std::stringstream stream(source);
-		return fromStream(stream);
+public:
+	struct Statistics {
+		size_t strings; // Distinct strings in the table
+		size_t hits; // Parsed strings that were found in the table
+		size_t bytesSaved; // Memory that would be allocated for the strings that were found
+	};
+
+	/*!
+	* \brief Starts interning strings parsed by this thread, until destroyed
+	* \param Maximal number of distinct strings, once full, new strings are no longer added
+	*/
+	StringInterner(size_t capacity = std::numeric_limits<size_t>::max()) : _capacity(capacity), _previous(current()) {
+		current() = this;
+	}
+	StringInterner(const StringInterner&) = delete;
+	~StringInterner() {
+		current() = _previous;
 	}
 
-	static void toStream(const Serialisable::JSON& serialised, std::ostream& stream, int depth = 0) {
-		switch(serialised.type()) {
-		case Serialisable::JSON::Type::NIL:
-			stream << "null";
-			break;
-		case Serialisable::JSON::Type::NUMBER:
-			stream << serialised.number();
-			break;
-		case Serialisable::JSON::Type::BOOL:
-			stream << (serialised.boolean() ? "true" : "false");
-			break;
-		case Serialisable::JSON::Type::STRING:
-			stream.put('"');
-			stream << serialised.string();
-			stream.put('"');
-			break;
-		case Serialisable::JSON::Type::OBJECT:
-		{
-			stream.put('{');
-			const auto object = serialised.object();
-			if (object.empty()) {
-				stream.put('}');
-				return;
+	Serialisable::JSON intern(const std::string& value) {
+		if (value.size() <= Serialisable::JSON::STRING_BREAKPOINT)
+			return Serialisable::JSON(value);
+		auto found = _strings.find(View{ value.data(), value.size() });
+		if (found != _strings.end()) {
+			_hits++;
+			_bytesSaved += found->second.allocatedSize();
+			return found->second;
+		}
+		Serialisable::JSON made(value);
+		if (_strings.size() < _capacity)
+			_strings.emplace(View{ made.getHeap<char>(), value.size() }, made);
+		return made;
+	}
+
+	Statistics statistics() const {
+		return { _strings.size(), _hits, _bytesSaved };
+	}
+
+	// Creates a parsed string, interned if there's an interner for this thread
+	static Serialisable::JSON parsed(const std::string& value) {
+		StringInterner* interner = current();
+		if (interner)
+			return interner->intern(value);
+		return Serialisable::JSON(value);
+	}
+};
+
+/*!
+* \brief While it exists, objects held by shared pointers are saved and loaded by the current thread only once
+*
+* \note The first occurrence gets an identifier under "$id", later occurrences are saved as {"$ref": identifier}
+* \note On load, the references are shared pointers to the same object again, cycles are preserved as well
+* \note Values that are not derived from Serialisable are wrapped as {"$id": identifier, "$value": value},
+* so are objects that have a member with one of these names themselves
+* \note Identifiers start again with every outermost toJSON() or fromJSON(), so each saved or loaded file stands on its own
+*/
+class SharedObjectTracking {
+	struct Loaded {
+		std::shared_ptr<void> object;
+		const std::type_info* type = nullptr;
+		bool defined = false;
+	};
+	std::unordered_map<const void*, double> _savedIds;
+	std::unordered_map<int64_t, Loaded> _loaded;
+	SharedObjectTracking* _previous;
+	int _depth = 0; // Of nested SharedObjectDocument instances
+	friend class SharedObjectDocument;
+
+	Loaded& entry(int64_t id, const std::type_info& type) {
+		Loaded& found = _loaded[id];
+		if (found.type && *found.type != type)
+			throw Serialisable::SerialisationError("Shared object " + std::to_string(id) + " is referenced as different types");
+		found.type = &type;
+		return found;
+	}
+
+public:
+	constexpr static const char* ID_KEY = "$id";
+	constexpr static const char* REFERENCE_KEY = "$ref";
+	constexpr static const char* VALUE_KEY = "$value";
+
+	SharedObjectTracking() : _previous(current()) {
+		current() = this;
+	}
+	SharedObjectTracking(const SharedObjectTracking&) = delete;
+	~SharedObjectTracking() {
+		current() = _previous;
+	}
+
+	static SharedObjectTracking*& current() {
+		thread_local SharedObjectTracking* instance = nullptr;
+		return instance;
+	}
+
+	/*!
+	* \brief Saves a shared object, or a reference to it if it was already saved
+	* \param The object's address
+	* \param Function that serialises the object, called only for its first occurrence
+	* \param Whether the identifier can be added to the serialised object rather than wrapping it
+	* \return The constructed JSON
+	*/
+	template <typename Function>
+	Serialisable::JSON save(const void* address, Function serialise, bool addIdInside) {
+		Serialisable::JSON made;
+		auto found = _savedIds.find(address);
+		if (found != _savedIds.end()) {
+			made.setObject()[REFERENCE_KEY] = found->second;
+			return made;
+		}
+		double id = double(_savedIds.size());
+		_savedIds.emplace(address, id); // Before serialising it, so that cycles become references
+		Serialisable::JSON contents = serialise();
+		if (addIdInside && contents.type() == Serialisable::JSON::Type::OBJECT && !hasReservedKeys(contents.object())) {
+			contents[ID_KEY] = id;
+			return contents;
+		}
+		Serialisable::JSON::ObjectType& wrapper = made.setObject();
+		wrapper.reserve(2);
+		wrapper[ID_KEY] = id;
+		wrapper[VALUE_KEY] = std::move(contents);
+		return made;
+	}
+
+	/*!
+	* \brief Loads a shared object, or a pointer to an already loaded one if it's a reference
+	* \param Reference to the result value
+	* \param The JSON
+	* \param Function that deserialises the object from its JSON, called only if it's not a reference
+	* \throw If the same identifier is used by different types or defined twice
+	* \note A reference to an object defined later gets the object that will be loaded there
+	*/
+	template <typename T, typename Function>
+	void load(std::shared_ptr<T>& result, const Serialisable::JSON& value, Function deserialise) {
+		load(result, value, deserialise, [] (std::shared_ptr<T>& made, const Serialisable::JSON*) {
+			if (!made)
+				made = std::make_shared<T>();
+		});
+	}
+
+	/*!
+	* \brief Loads a shared object, or a pointer to an already loaded one if it's a reference, letting the caller create the object
+	* \param Reference to the result value
+	* \param The JSON
+	* \param Function that deserialises the object from its JSON, called only if it's not a reference
+	* \param Function that fills an empty or reused pointer with an object for the JSON, which is null for a reference to an object defined later
+	* \throw If the same identifier is used by different types or defined twice
+	*/
+	template <typename T, typename Function, typename Creator>
+	void load(std::shared_ptr<T>& result, const Serialisable::JSON& value, Function deserialise, Creator create) {
+		const Serialisable::JSON::ObjectType& object = value.object();
+		auto reference = object.find(REFERENCE_KEY);
+		if (reference != object.end() && object.size() == 1) {
+			Loaded& found = entry(int64_t(reference->second.number()), typeid(T));
+			if (!found.object) { // Will be filled when its definition is found
+				std::shared_ptr<T> made;
+				create(made, nullptr);
+				found.object = made;
+			}
+			result = std::static_pointer_cast<T>(found.object);
+			return;
+		}
+		auto id = object.find(ID_KEY);
+		if (id == object.end()) { // Saved without tracking
+			create(result, &value);
+			deserialise(*result, value);
+			return;
+		}
+		Loaded& found = entry(int64_t(id->second.number()), typeid(T));
+		if (found.defined)
+			throw Serialisable::SerialisationError("Shared object " + std::to_string(int64_t(id->second.number())) + " is defined twice");
+		found.defined = true;
+		auto contents = object.find(VALUE_KEY);
+		const Serialisable::JSON& definition = (contents != object.end()) ? contents->second : value;
+		if (!found.object) {
+			std::shared_ptr<T> made;
+			create(made, &definition);
+			found.object = made;
+		}
+		result = std::static_pointer_cast<T>(found.object);
+		deserialise(*result, definition);
+	}
+
+private:
+	// Objects with members named like the markup are wrapped, so that their members aren't mistaken for it
+	static bool hasReservedKeys(const Serialisable::JSON::ObjectType& object) {
+		return object.find(ID_KEY) != object.end() || object.find(REFERENCE_KEY) != object.end() || object.find(VALUE_KEY) != object.end();
+	}
+};
+
+SharedObjectDocument::SharedObjectDocument() : _tracking(SharedObjectTracking::current()) {
+	if (_tracking && _tracking->_depth++ == 0) {
+		_tracking->_savedIds.clear();
+		_tracking->_loaded.clear();
+	}
+}
+
+SharedObjectDocument::~SharedObjectDocument() {
+	if (_tracking)
+		_tracking->_depth--;
+}
+
+// Formats that can write into any object with push_back(uint8_t), like CondensedJSON
+template <typename Format, typename Sink, typename SFINAE = void>
+struct WritesIntoSink : std::false_type { };
+
+template <typename Format, typename Sink>
+struct WritesIntoSink<Format, Sink, decltype(Format::serialiseInto(std::declval<const Serialisable::JSON&>(), std::declval<Sink&>()))>
+		: std::true_type { };
+
+// Formats that can read from a range of bytes without having them in a container, like CondensedJSON
+template <typename Format, typename SFINAE = void>
+struct ReadsBytes : std::false_type { };
+
+template <typename Format>
+struct ReadsBytes<Format, decltype(void(Format::deserialiseBytes(std::declval<const uint8_t*>(), size_t())))> : std::true_type { };
+
+// Formats that can parse while reading, like JSONformat
+template <typename Format, typename SFINAE = void>
+struct ReadsStreams : std::false_type { };
+
+template <typename Format>
+struct ReadsStreams<Format, std::enable_if_t<std::is_same<decltype(Format::fromStream(std::declval<std::istream&>())), Serialisable::JSON>::value>>
+		: std::true_type { };
+
+// Decodes data where they are if the format allows it, otherwise copies them into what the format reads from
+template <typename Format, bool inPlace = ReadsBytes<Format>::value>
+struct BytesDecoder {
+	static Serialisable::JSON decode(const uint8_t* data, size_t size) {
+		return Format::deserialiseBytes(data, size);
+	}
+};
+
+template <typename Format>
+struct BytesDecoder<Format, false> {
+	static Serialisable::JSON decode(const uint8_t* data, size_t size) {
+		std::decay_t<decltype(getArgType(&Format::deserialise))> copied(data, data + size);
+		return Format::deserialise(copied);
+	}
+};
+
+// Power of two with at least two slots per name
+constexpr size_t nameHashSlots(size_t names) {
+	size_t slots = 1;
+	while (slots < 2 * names)
+		slots <<= 1;
+	return slots;
+}
+
+/*!
+* \brief Perfect hash table finding the index of a name from a fixed set without comparing it to more than one of them
+*
+* \note It can be constructed at compile time, finding the hash seeds may take long for thousands of names
+* \note The names must remain allocated while it's used
+*/
+template <size_t N>
+class NameHash {
+	constexpr static size_t BUCKETS = N > 0 ? N : 1;
+	constexpr static size_t SLOTS = nameHashSlots(N);
+	constexpr static uint32_t MAX_SEED = 0x10000;
+
+	const char* _names[BUCKETS];
+	size_t _lengths[BUCKETS];
+	uint32_t _seeds[BUCKETS];
+	int _slots[SLOTS];
+
+	constexpr static size_t length(const char* text) {
+		size_t size = 0;
+		while (text[size])
+			size++;
+		return size;
+	}
+
+	constexpr static uint32_t hash(const char* text, size_t length, uint32_t seed) {
+		uint32_t value = 2166136261u ^ (seed * 0x9e3779b9u); // FNV-1a with a seed
+		for (size_t i = 0; i < length; i++)
+			value = (value ^ uint8_t(text[i])) * 16777619u;
+		return value ^ (value >> 15);
+	}
+
+public:
+	/*!
+	* \brief Finds seeds that map each name into a different slot, hash and displace style
+	* \param The names, their order gives their indexes
+	* \throw If the names are not unique (at compile time, it's a compilation error)
+	*/
+	constexpr NameHash(const std::array<const char*, N>& names) : _names(), _lengths(), _seeds(), _slots() {
+		for (size_t i = 0; i < SLOTS; i++)
+			_slots[i] = -1;
+		size_t bucketOf[BUCKETS] = {};
+		size_t firstMember[BUCKETS + 1] = {};
+		for (size_t i = 0; i < N; i++) {
+			_names[i] = names[i];
+			_lengths[i] = length(names[i]);
+			bucketOf[i] = hash(_names[i], _lengths[i], 0) % BUCKETS;
+			firstMember[bucketOf[i] + 1]++;
+		}
+		size_t largest = 0;
+		for (size_t i = 0; i < BUCKETS; i++) {
+			if (firstMember[i + 1] > largest)
+				largest = firstMember[i + 1];
+			firstMember[i + 1] += firstMember[i];
+		}
+		size_t members[BUCKETS] = {}; // Names grouped by bucket
+		size_t filled[BUCKETS] = {};
+		for (size_t i = 0; i < N; i++)
+			members[firstMember[bucketOf[i]] + filled[bucketOf[i]]++] = i;
+
+		// Buckets with more names are placed first, while there's more free space
+		for (size_t size = largest; size > 0; size--) {
+			for (size_t bucket = 0; bucket < BUCKETS; bucket++) {
+				if (firstMember[bucket + 1] - firstMember[bucket] != size)
+					continue;
+				for (uint32_t seed = 1; ; seed++) {
+					if (seed == MAX_SEED)
+						throw std::logic_error("Names given to a perfect hash table are not unique");
+					size_t placed = firstMember[bucket];
+					for ( ; placed < firstMember[bucket + 1]; placed++) {
+						size_t member = members[placed];
+						size_t slot = hash(_names[member], _lengths[member], seed) & (SLOTS - 1);
+						if (_slots[slot] != -1)
+							break;
+						_slots[slot] = int(member);
+					}
+					if (placed == firstMember[bucket + 1]) {
+						_seeds[bucket] = seed;
+						break;
+					}
+					for (size_t j = firstMember[bucket]; j < placed; j++) // Revert a partial placement
+						_slots[hash(_names[members[j]], _lengths[members[j]], seed) & (SLOTS - 1)] = -1;
+				}
+			}
+		}
+	}
+
+	/*!
+	* \brief Finds the index of a name
+	* \param The text, doesn't need to be zero-terminated
+	* \param The text's length
+	* \return The index, -1 if it's not one of the names
+	*/
+	constexpr int find(const char* text, size_t length) const {
+		if (N == 0)
+			return -1;
+		uint32_t seed = _seeds[hash(text, length, 0) % BUCKETS];
+		int index = _slots[hash(text, length, seed) & (SLOTS - 1)];
+		if (index < 0 || _lengths[index] != length)
+			return -1;
+		for (size_t i = 0; i < length; i++)
+			if (_names[index][i] != text[i])
+				return -1;
+		return index;
+	}
+
+	/*!
+	* \brief Finds the index of a name held by a JSON string, without allocating
+	* \param The JSON
+	* \return The index, -1 if it's not one of the names
+	* \throw If it's not a string
+	*/
+	int find(const Serialisable::JSON& value) const {
+		Serialisable::JSON::ShortStringBuffer buffer;
+		size_t textLength = 0;
+		const char* text = value.stringData(buffer, textLength);
+		return find(text, textLength);
+	}
+
+	constexpr const char* name(size_t index) const {
+		return _names[index];
+	}
+};
+
+// Parsed contents of objects and arrays are collected here until their size is known, so that the containers are allocated only once
+struct ParsingStacks {
+	std::vector<std::pair<Serialisable::JSON::String, Serialisable::JSON>> members;
+	std::vector<Serialisable::JSON> elements;
+	std::string text; // The string or number being read, kept to reuse its capacity
+
+	static ParsingStacks& local() {
+		thread_local ParsingStacks instance;
+		return instance;
+	}
+
+	// Moves the members pushed since the given position into a new object
+	Serialisable::JSON popObject(size_t start) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ObjectType& object = made.setObject();
+		object.reserve(members.size() - start);
+		for (size_t i = start; i < members.size(); i++)
+			object[std::move(members[i].first)] = std::move(members[i].second);
+		members.resize(start);
+		return made;
+	}
+
+	// Moves the elements pushed since the given position into a new array
+	Serialisable::JSON popArray(size_t start) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(elements.size() - start);
+		for (size_t i = start; i < elements.size(); i++)
+			array.push_back(std::move(elements[i]));
+		elements.resize(start);
+		return made;
+	}
+};
+
+// Lets an std::ostream write into anything with push_back(char), like a caller's std::string
+// The stream should have badbit exceptions enabled, so that exceptions thrown by the sink reach the caller
+template <typename Sink>
+class SinkStreamBuffer : public std::streambuf {
+	Sink& _sink;
+	char _pending[256]; // Characters are gathered here, so that a virtual call isn't needed for every one of them
+
+	template <typename Target>
+	static void append(Target& target, const char* data, size_t size) {
+		for (size_t i = 0; i < size; i++)
+			target.push_back(data[i]);
+	}
+	static void append(std::string& target, const char* data, size_t size) {
+		target.append(data, size);
+	}
+	static void append(std::vector<uint8_t>& target, const char* data, size_t size) {
+		target.insert(target.end(), data, data + size);
+	}
+	void flushPending() {
+		append(_sink, pbase(), pptr() - pbase());
+		setp(_pending, _pending + sizeof(_pending));
+	}
+protected:
+	int_type overflow(int_type written) override {
+		flushPending();
+		if (written != traits_type::eof())
+			_sink.push_back(traits_type::to_char_type(written));
+		return written;
+	}
+	int sync() override {
+		flushPending();
+		return 0;
+	}
+public:
+	SinkStreamBuffer(Sink& sink) : _sink(sink) {
+		setp(_pending, _pending + sizeof(_pending));
+	}
+
+	// Passes the remaining characters to the sink, they are discarded if it's destroyed without this (after an exception)
+	void finish() {
+		flushPending();
+	}
+};
+
+// Lets an std::istream read from memory it doesn't own
+class MemoryStreamBuffer : public std::streambuf {
+public:
+	MemoryStreamBuffer(const char* data, size_t size) {
+		char* start = const_cast<char*>(data); // It's only read
+		setg(start, start, start + size);
+	}
+};
+
+struct JSONformat {
+	static std::string serialise(const Serialisable::JSON& serialised)  {
+		std::string made;
+		serialiseInto(serialised, made);
+		return made;
+	}
+
+	// Appends the text to anything with push_back(char), without an intermediate buffer
+	template <typename Sink>
+	static void serialiseInto(const Serialisable::JSON& serialised, Sink& sink) {
+		SinkStreamBuffer<Sink> buffer(sink);
+		std::ostream stream(&buffer);
+		stream.exceptions(std::ios::badbit);
+		toStream(serialised, stream, 0);
+		buffer.finish();
+	}
+
+	static Serialisable::JSON deserialise(const std::string& source) {
+		return deserialiseBytes(reinterpret_cast<const uint8_t*>(source.data()), source.size());
+	}
+
+	// Parses the text where it is, without copying it
+	static Serialisable::JSON deserialiseBytes(const uint8_t* source, size_t size) {
+		MemoryStreamBuffer buffer(reinterpret_cast<const char*>(source), size);
+		std::istream stream(&buffer);
+		return fromStream(stream);
+	}
+
+	// If compact, it writes no whitespace and escapes line breaks in all strings, so that the result is on one line
+	static void toStream(const Serialisable::JSON& serialised, std::ostream& stream, int depth = 0, bool compact = false) {
+		switch(serialised.type()) {
+		case Serialisable::JSON::Type::NIL:
+			stream << "null";
+			break;
+		case Serialisable::JSON::Type::NUMBER:
+		{
+			double number = serialised.number();
+			constexpr double MAX_EXACT = double(int64_t(1) << std::numeric_limits<double>::digits);
+			if (number == std::floor(number) && std::abs(number) <= MAX_EXACT)
+				stream << int64_t(number); // Integers such as timestamps would be rounded to 6 digits otherwise
+			else
+				stream << number;
+			break;
+		}
+		case Serialisable::JSON::Type::BOOL:
+			stream << (serialised.boolean() ? "true" : "false");
+			break;
+		case Serialisable::JSON::Type::STRING:
+		{
+			Serialisable::JSON::ShortStringBuffer buffer;
+			size_t length = 0;
+			const char* text = serialised.stringData(buffer, length);
+			writeString(stream, text, length);
+			break;
+		}
+		case Serialisable::JSON::Type::OBJECT:
+		{
+			stream.put('{');
+			const auto& object = serialised.object();
+			if (object.empty()) {
+				stream.put('}');
+				return;
 			}
-			stream.put('\n');
+			if (!compact)
+				stream.put('\n');
 			bool first = true;
-			for (auto& it : object) {
+			auto writeMember = [&] (const auto& member) {
 				if (first)
 					first = false;
 				else {
 					stream.put(',');
-					stream.put('\n');
+					if (!compact)
+						stream.put('\n');
 				}
-				indent(stream, depth + 1);
-				writeString(stream, it.first);
+				if (!compact)
+					indent(stream, depth + 1);
+				writeString(stream, member.first);
 				stream.put(':');
-				stream.put(' ');
-				toStream(it.second, stream, depth + 1);
+				if (!compact)
+					stream.put(' ');
+				toStream(member.second, stream, depth + 1, compact);
+			};
+			const char* leadingKey = serialised.leadingMember();
+			auto leading = leadingKey ? object.find(leadingKey) : object.end();
+			if (leading != object.end())
+				writeMember(*leading);
+			for (auto& it : object)
+				if (leading == object.end() || &it != &*leading)
+					writeMember(it);
+			if (!compact) {
+				stream.put('\n');
+				indent(stream, depth);
 			}
-			stream.put('\n');
-			indent(stream, depth);
 			stream.put('}');
 			break;
 		}
@@ -1033,13 +2271,17 @@ struct JSONformat {
 				return;
 			}
 			for (unsigned int i = 0; i < array.size(); i++) {
-				stream.put('\n');
-				indent(stream, depth + 1);
-				toStream(array[i], stream, depth + 1);
+				if (!compact) {
+					stream.put('\n');
+					indent(stream, depth + 1);
+				}
+				toStream(array[i], stream, depth + 1, compact);
 				if (i < array.size() - 1) stream.put(',');
 			}
-			stream.put('\n');
-			indent(stream, depth);
+			if (!compact) {
+				stream.put('\n');
+				indent(stream, depth);
+			}
 			stream.put(']');
 			break;
 		}
@@ -1053,10 +2295,13 @@ struct JSONformat {
 			out.put('\t');
 	}
 	static void writeString(std::ostream& out, const std::string& written) {
+		writeString(out, written.data(), written.size());
+	}
+	static void writeString(std::ostream& out, const char* written, size_t size) {
 		out.put('"');
-		for (unsigned int i = 0; i < written.size(); i++) {
+		for (size_t i = 0; i < size; i++) {
 			if (written[i] == '"') {
-				out.put('/');
+				out.put('\\');
 				out.put('"');
 			} else if (written[i] == '\n') {
 				out.put('\\');
@@ -1070,35 +2315,39 @@ struct JSONformat {
 		out.put('"');
 	}
 
-	static Serialisable::JSON fromStream(std::istream& stream) {
-		auto readString = [&stream] () -> std::string {
-			char letter = stream.get();
-			std::string collected;
-			while (letter != '"') {
-				if (letter == '\\') {
-					letter = stream.get();
-					if (letter == '"') collected.push_back('"');
-					else if (letter == 'n') collected.push_back('\n');
-					else if (letter == '\\') collected.push_back('\\');
-				} else {
-					collected.push_back(letter);
-				}
+	// Reads a string after its opening quote
+	static void readString(std::istream& stream, std::string& collected) {
+		char letter = stream.get();
+		collected.clear();
+		while (letter != '"') {
+			if (letter == '\\') {
 				letter = stream.get();
+				if (letter == '"') collected.push_back('"');
+				else if (letter == 'n') collected.push_back('\n');
+				else if (letter == '\\') collected.push_back('\\');
+			} else {
+				collected.push_back(letter);
 			}
-			return collected;
-		};
-		auto readWhitespace = [&stream] () -> char {
-			char letter;
-			do {
-				letter = stream.get();
-			} while (letter == ' ' || letter == '\t' || letter == '\n' || letter == ',');
-			return letter;
-		};
+			letter = stream.get();
+		}
+	}
+
+	// Skips whitespace and separators, returns the first letter after them
+	static char readWhitespace(std::istream& stream) {
+		char letter;
+		do {
+			letter = stream.get();
+		} while (letter == ' ' || letter == '\t' || letter == '\n' || letter == ',');
+		return letter;
+	}
 
-		char letter = readWhitespace();
+	static Serialisable::JSON fromStream(std::istream& stream) {
+		std::string& collected = ParsingStacks::local().text;
+		char letter = readWhitespace(stream);
 		if (letter == 0 || letter == EOF) return Serialisable::JSON();
 		else if (letter == '"') {
-			return Serialisable::JSON(readString());
+			readString(stream, collected);
+			return StringInterner::parsed(collected);
 		}
 		else if (letter == 't') {
 			if (stream.get() == 'r' && stream.get() == 'u' && stream.get() == 'e')
@@ -1119,7 +2368,8 @@ struct JSONformat {
 				throw(std::runtime_error("JSON parser found misspelled keyword 'null'"));
 		}
 		else if (letter == '-' || (letter >= '0' && letter <= '9') || letter == '+' || letter == '.') {
-			std::string asString;
+			std::string& asString = collected;
+			asString.clear();
 			asString.push_back(letter);
 			letter = stream.get();
 			while (letter == '-' || letter == '+' || letter == 'E' || letter == 'e' || letter == '.' || (letter >= '0' && letter <= '9')) {
@@ -1128,89 +2378,545 @@ struct JSONformat {
 				letter = stream.get();
 			}
 			stream.unget();
-			std::stringstream parsing(asString);
-			double number;
-			parsing >> number;
+			double number = 0;
+#if defined(__cpp_lib_to_chars)
+			std::from_chars(asString.data() + (asString[0] == '+'), asString.data() + asString.size(), number);
+#else
+			number = std::strtod(asString.c_str(), nullptr); // Assumes the C locale uses a decimal point
+#endif
 			return Serialisable::JSON(number);
 		}
 		else if (letter == '{') {
-			Serialisable::JSON retval;
-			retval.setObject();
-			do {
-				letter = readWhitespace();
-				if (letter == '"') {
-					const std::string& name = readString();
-					letter = readWhitespace();
-					if (letter != ':') throw(std::runtime_error("JSON parser expected an additional ':' somewhere"));
-					retval[name] = fromStream(stream);
-				} else break;
-			} while (letter != '}');
-			return retval;
+			ParsingStacks& stacks = ParsingStacks::local();
+			size_t start = stacks.members.size();
+			try {
+				do {
+					letter = readWhitespace(stream);
+					if (letter == '"') {
+						readString(stream, collected);
+						Serialisable::JSON::String name = collected;
+						letter = readWhitespace(stream);
+						if (letter != ':') throw(std::runtime_error("JSON parser expected an additional ':' somewhere"));
+						Serialisable::JSON value = fromStream(stream);
+						stacks.members.emplace_back(std::move(name), std::move(value));
+					} else break;
+				} while (letter != '}');
+			} catch (...) {
+				stacks.members.resize(start);
+				throw;
+			}
+			return stacks.popObject(start);
 		}
 		else if (letter == '[') {
-			Serialisable::JSON retval;
-			auto& array = retval.setArray();
-			letter = readWhitespace();
-			while (letter != ']') {
-				stream.unget();
-				array.push_back(fromStream(stream));
-				letter = readWhitespace();
+			ParsingStacks& stacks = ParsingStacks::local();
+			size_t start = stacks.elements.size();
+			try {
+				letter = readWhitespace(stream);
+				while (letter != ']') {
+					stream.unget();
+					Serialisable::JSON value = fromStream(stream);
+					stacks.elements.push_back(std::move(value));
+					letter = readWhitespace(stream);
+				}
+			} catch (...) {
+				stacks.elements.resize(start);
+				throw;
 			}
-			return retval;
+			return stacks.popArray(start);
 		} else {
 			throw std::runtime_error(std::string("JSON parser found unexpected character ") + letter);
 		}
 		return Serialisable::JSON();
 	}
+
+	/*!
+	* \brief Reads the members of an object from a stream one by one, for Serialisable::fromMembers()
+	*
+	* \note The opening brace is read when it's created, the stream is after the object once all members are read
+	*/
+	class MemberReader : public Serialisable::MemberSource {
+		std::istream& _stream;
+		bool _finished = false;
+	public:
+		MemberReader(std::istream& stream) : _stream(stream) {
+			char letter = readWhitespace(stream);
+			if (letter != '{')
+				throw std::runtime_error(std::string("JSON parser expected an object, found ") + letter);
+		}
+		bool nextName(std::string& name) override {
+			if (_finished)
+				return false;
+			if (readWhitespace(_stream) != '"') {
+				_finished = true;
+				return false;
+			}
+			readString(_stream, name);
+			if (readWhitespace(_stream) != ':')
+				throw std::runtime_error("JSON parser expected an additional ':' somewhere");
+			return true;
+		}
+		Serialisable::JSON value() override {
+			return fromStream(_stream);
+		}
+	};
 };
 
-template <typename Format>
-struct DiskAccessor<Format, std::enable_if<
-		std::is_same<decltype(Format::toStream(std::declval<Serialisable::JSON>(), std::declval<std::ostream>())), void>::value &&
-		std::is_same<decltype(Format::fromStream(std::declval<std::ostream>())), Serialisable::JSON>::value>> {
+// The same as JSONformat, but each JSON is written on a single line without whitespace, as in newline-delimited JSON
+struct CompactJSONformat : JSONformat {
+	static std::string serialise(const Serialisable::JSON& serialised)  {
+		std::string made;
+		serialiseInto(serialised, made);
+		return made;
+	}
 
-	template <typename Internal>
-	static void save(const std::string& fileName, const Internal& source) {
-		std::ofstream stream(fileName, std::ios::binary);
-		Format::toStream(source, stream);
+	template <typename Sink>
+	static void serialiseInto(const Serialisable::JSON& serialised, Sink& sink) {
+		SinkStreamBuffer<Sink> buffer(sink);
+		std::ostream stream(&buffer);
+		stream.exceptions(std::ios::badbit);
+		JSONformat::toStream(serialised, stream, 0, true);
+		buffer.finish();
 	}
 
-	template <typename Internal>
-	static Internal load(const std::string& fileName) {
-		std::ifstream stream(fileName, std::ios::binary);
-		stream >> std::noskipws;
-		return Format::fromStream(stream);
+	static void toStream(const Serialisable::JSON& serialised, std::ostream& stream, int = 0) {
+		JSONformat::toStream(serialised, stream, 0, true);
 	}
 };
-}
 
-inline std::string Serialisable::JSON::toString() const {
-	return to<SerialisableInternals::JSONformat>();
-}
+// Receives output in chunks that another thread writes into a file while the following chunks are being filled
+// Output that fits into one chunk is written without starting the thread, the file is opened only once something is written
+// Larger output is written into a temporary file that replaces the target once complete, so a failure doesn't leave it truncated
+class PipelinedFileWriter {
+	constexpr static size_t CHUNK_SIZE = 1 << 16;
+	constexpr static int CHUNKS = 4; // At most this many are allocated, filling waits until one of them is written
 
-inline Serialisable::JSON Serialisable::JSON::fromString(const std::string& source) {
-	return from<SerialisableInternals::JSONformat>(source);
-}
+	std::string _fileName;
+	std::string _temporaryName; // Set when the thread starts
+	std::ofstream _file;
+	std::array<std::unique_ptr<char[]>, CHUNKS> _chunks;
+	std::array<size_t, CHUNKS> _sizes;
+	char* _position = nullptr;
+	char* _end = nullptr;
+	size_t _filled = 0; // Chunks handed over for writing, guarded by _lock once the thread runs
+	size_t _written = 0; // Guarded by _lock
+	bool _failed = false; // Guarded by _lock
+	bool _finishing = false;
+	bool _finished = false;
+	std::mutex _lock;
+	std::condition_variable _changed;
+	std::thread _writer;
 
-inline void Serialisable::JSON::save(const std::string& fileName) const {
-	saveAs<SerialisableInternals::JSONformat>(fileName);
-}
+	void run() {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "write " + _fileName);
+		std::unique_lock<std::mutex> lock(_lock);
+		while (true) {
+			_changed.wait(lock, [this] () { return _written < _filled || _finishing; });
+			if (_written == _filled)
+				return;
+			size_t index = _written % CHUNKS;
+			bool failed = _failed;
+			lock.unlock();
+			if (!failed)
+				failed = !_file.write(_chunks[index].get(), _sizes[index]);
+			lock.lock();
+			_failed = failed; // Later chunks are only discarded, so that filling doesn't wait forever
+			_written++;
+			_changed.notify_all();
+		}
+	}
 
-inline Serialisable::JSON Serialisable::JSON::load(const std::string& fileName) {
-	return loadAs<SerialisableInternals::JSONformat>(fileName);
-}
+	// The target is replaced only when the whole file is written
+	void openTemporary() {
+		_temporaryName = _fileName + ".saving";
+		_file.open(_temporaryName, std::ios::binary);
+		if (!_file.is_open())
+			throw std::runtime_error("Could not open " + _temporaryName + " for writing");
+	}
 
-namespace SerialisableInternals {
-template <typename Serialised>
-struct Serialiser<Serialised, std::enable_if_t<std::is_integral<Serialised>::value>> {
-	constexpr static bool valid = true;
-	/*!
-	* \brief Saves an arithmetic integer value
-	* \param The value
-	* \return The constructed JSON
-	*/
-	static Serialisable::JSON serialise(Serialised value) {
-		return Serialisable::JSON(value);
+	void handOver() {
+		size_t index = _filled % CHUNKS;
+		_sizes[index] = _position - _chunks[index].get();
+		if (!_writer.joinable()) {
+			openTemporary();
+			_filled++;
+			_writer = std::thread([this] () { run(); });
+		} else {
+			std::lock_guard<std::mutex> lock(_lock);
+			_filled++;
+			_changed.notify_all();
+		}
+	}
+
+	void nextChunk() {
+		if (_position) {
+			handOver();
+			std::unique_lock<std::mutex> lock(_lock);
+			_changed.wait(lock, [this] () { return _filled - _written < CHUNKS; });
+			if (_failed)
+				throw std::runtime_error("Could not write " + _temporaryName);
+		}
+		std::unique_ptr<char[]>& chunk = _chunks[_filled % CHUNKS];
+		if (!chunk)
+			chunk.reset(new char[CHUNK_SIZE]);
+		_position = chunk.get();
+		_end = _position + CHUNK_SIZE;
+	}
+
+	void stopWriting() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_finishing = true;
+			_changed.notify_all();
+		}
+		_writer.join();
+	}
+
+public:
+	PipelinedFileWriter(const std::string& fileName) : _fileName(fileName) { }
+	PipelinedFileWriter(const PipelinedFileWriter&) = delete;
+	// If it wasn't finished (encoding threw an exception), the temporary file is deleted and the target is left as it was
+	~PipelinedFileWriter() {
+		if (_writer.joinable())
+			stopWriting();
+		if (!_finished && !_temporaryName.empty()) {
+			_file.close();
+			std::remove(_temporaryName.c_str());
+		}
+	}
+
+	void push_back(char value) {
+		if (_position == _end)
+			nextChunk();
+		*_position++ = value;
+	}
+
+	// Writes what remains, waits until all is written and moves it to the target, throws if anything couldn't be written
+	void finish() {
+		if (!_writer.joinable()) { // Fits into one chunk, written without starting the thread
+			openTemporary();
+			if (_position)
+				_file.write(_chunks[0].get(), _position - _chunks[0].get());
+		} else {
+			handOver();
+			stopWriting();
+		}
+		_file.close();
+		if (_failed || _file.fail())
+			throw std::runtime_error("Could not write " + _temporaryName);
+#ifndef SERIALISABLE_BY_DUGI_POSIX_FILES
+		std::remove(_fileName.c_str()); // Renaming doesn't replace existing files everywhere
+#endif
+		if (std::rename(_temporaryName.c_str(), _fileName.c_str()) != 0)
+			throw std::runtime_error("Could not replace " + _fileName + " by " + _temporaryName);
+		_finished = true;
+	}
+};
+
+// Formats with serialiseInto() are written while they are being encoded, others are encoded whole and then written at once
+template <typename Format, bool pipelined = WritesIntoSink<Format, PipelinedFileWriter>::value>
+struct FileSaver {
+	static void save(const std::string& fileName, const Serialisable::JSON& source) {
+		auto serialised = [&] {
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("encode", Tracing::typeName(typeid(Format)) + "::serialise");
+			return Format::serialise(source);
+		}();
+		std::ofstream stream = [&] {
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "open " + fileName);
+			return std::ofstream(fileName, std::ios::binary);
+		}();
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "write " + fileName);
+		stream.write(reinterpret_cast<const char*>(serialised.data()), serialised.size() * sizeof(*serialised.data()));
+		stream.close();
+		if (stream.fail())
+			throw std::runtime_error("Could not write " + fileName);
+	}
+};
+
+template <typename Format>
+struct FileSaver<Format, true> {
+	static void save(const std::string& fileName, const Serialisable::JSON& source) {
+		PipelinedFileWriter writer(fileName);
+		{
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("encode", Tracing::typeName(typeid(Format)) + "::serialiseInto");
+			Format::serialiseInto(source, writer);
+		}
+		writer.finish();
+	}
+};
+
+// Reads a file on another thread in large chunks ahead of what is being parsed, keeping only a few of them in memory
+// Files that fit into one chunk are read without starting the thread
+class PrefetchingFileBuffer : public std::streambuf {
+	constexpr static size_t CHUNK_SIZE = 1 << 18;
+	constexpr static int CHUNKS = 4;
+
+	std::string _fileName;
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+	int _descriptor;
+#else
+	std::ifstream _file;
+#endif
+	std::array<std::unique_ptr<char[]>, CHUNKS> _chunks;
+	std::array<size_t, CHUNKS> _sizes = {};
+	size_t _read = 0; // Chunks read, guarded by _lock once the thread runs
+	size_t _taken = 0; // Chunks given to the parser, the last one is being parsed, guarded by _lock
+	bool _finished = false; // Guarded by _lock
+	bool _stopping = false; // Guarded by _lock
+	std::string _error; // Why reading stopped before the end of the file, guarded by _lock once the thread runs
+	std::mutex _lock;
+	std::condition_variable _changed;
+	std::thread _reader;
+
+	// Fills a chunk, returns its size, zero at the end of the file, sets the error if reading fails
+	size_t readChunk(size_t number, std::string& error) {
+		std::unique_ptr<char[]>& chunk = _chunks[number % CHUNKS];
+		if (!chunk)
+			chunk.reset(new char[CHUNK_SIZE]);
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+#ifdef POSIX_FADV_WILLNEED
+		posix_fadvise(_descriptor, (number + 1) * CHUNK_SIZE, CHUNK_SIZE, POSIX_FADV_WILLNEED); // Reading the next one can start now
+#endif
+		size_t size = 0;
+		while (size < CHUNK_SIZE) {
+			ssize_t got = ::read(_descriptor, chunk.get() + size, CHUNK_SIZE - size);
+			if (got < 0 && errno == EINTR)
+				continue;
+			if (got < 0)
+				error = "Could not read " + _fileName + ": " + strerror(errno);
+			if (got <= 0)
+				break;
+			size += got;
+		}
+		return size;
+#else
+		_file.read(chunk.get(), CHUNK_SIZE);
+		if (_file.bad())
+			error = "Could not read " + _fileName;
+		return _file.gcount();
+#endif
+	}
+
+	void run() {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "read " + _fileName);
+		std::unique_lock<std::mutex> lock(_lock);
+		while (true) {
+			_changed.wait(lock, [this] () { return _stopping || _read - (_taken ? _taken - 1 : 0) < CHUNKS; });
+			if (_stopping)
+				return;
+			size_t number = _read;
+			std::string error;
+			lock.unlock();
+			size_t size = readChunk(number, error);
+			lock.lock();
+			_sizes[number % CHUNKS] = size;
+			_error = std::move(error);
+			if (size > 0)
+				_read++;
+			if (size < CHUNK_SIZE)
+				_finished = true;
+			_changed.notify_all();
+			if (_finished)
+				return;
+		}
+	}
+
+protected:
+	// The stream sets badbit if it throws, the exception reaches the caller if the stream's exceptions include badbit
+	int_type underflow() override {
+		if (gptr() < egptr())
+			return traits_type::to_int_type(*gptr());
+		std::unique_lock<std::mutex> lock(_lock);
+		_changed.wait(lock, [this] () { return _read > _taken || _finished; });
+		if (_read == _taken) {
+			if (!_error.empty())
+				throw std::runtime_error(_error);
+			return traits_type::eof();
+		}
+		char* chunk = _chunks[_taken % CHUNKS].get();
+		setg(chunk, chunk, chunk + _sizes[_taken % CHUNKS]);
+		_taken++;
+		_changed.notify_all(); // The previous chunk can be reused
+		return traits_type::to_int_type(*gptr());
+	}
+
+public:
+	PrefetchingFileBuffer(const std::string& fileName) : _fileName(fileName)
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+			, _descriptor(::open(fileName.c_str(), O_RDONLY | O_CLOEXEC)) {
+		if (_descriptor < 0)
+			throw std::runtime_error("Could not open " + fileName + ": " + strerror(errno));
+#ifdef POSIX_FADV_SEQUENTIAL
+		posix_fadvise(_descriptor, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+#else
+			, _file(fileName, std::ios::binary) {
+		if (!_file.is_open())
+			throw std::runtime_error("Could not open " + fileName);
+#endif
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "read " + _fileName);
+		_sizes[0] = readChunk(0, _error);
+		if (_sizes[0] > 0)
+			_read = 1;
+		if (_sizes[0] < CHUNK_SIZE)
+			_finished = true;
+		else
+			_reader = std::thread([this] () { run(); });
+	}
+	PrefetchingFileBuffer(const PrefetchingFileBuffer&) = delete;
+	~PrefetchingFileBuffer() {
+		if (_reader.joinable()) {
+			{
+				std::lock_guard<std::mutex> lock(_lock);
+				_stopping = true;
+				_changed.notify_all();
+			}
+			_reader.join();
+		}
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+		if (_descriptor >= 0)
+			::close(_descriptor);
+#endif
+	}
+};
+
+// Formats that can parse streams read files while they are being parsed, others read them whole first
+template <typename Format, bool streaming = ReadsStreams<Format>::value>
+struct FileLoader {
+	static Serialisable::JSON load(const std::string& fileName) {
+		std::decay_t<decltype(getArgType(&Format::deserialise))> making;
+		{
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "read " + fileName);
+			std::ifstream stream(fileName, std::ios::binary | std::ios::ate);
+			std::streamoff size = stream.tellg();
+			if (size > 0) {
+				making.resize(size / sizeof(*making.data()));
+				stream.seekg(0);
+				stream.read(reinterpret_cast<char*>(&making[0]), making.size() * sizeof(*making.data()));
+			}
+		}
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("decode", Tracing::typeName(typeid(Format)) + "::deserialise");
+		return Format::deserialise(making);
+	}
+};
+
+template <typename Format>
+struct FileLoader<Format, true> {
+	static Serialisable::JSON load(const std::string& fileName) {
+		PrefetchingFileBuffer buffer(fileName);
+		std::istream stream(&buffer);
+		stream.exceptions(std::ios::badbit); // Read errors are thrown rather than looking like the end of the file
+		stream >> std::noskipws;
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("decode", Tracing::typeName(typeid(Format)) + "::fromStream");
+		return Format::fromStream(stream);
+	}
+};
+
+template <typename Format, typename SFINAE>
+struct DiskAccessor {
+	template <typename Internal>
+	static void save(const std::string& fileName, const Internal& source) {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "save " + fileName);
+		FileSaver<Format>::save(fileName, source);
+	}
+
+	template <typename Internal>
+	static Internal load(const std::string& fileName) {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "load " + fileName);
+		return FileLoader<Format>::load(fileName);
+	}
+};
+
+template <typename Format>
+struct DiskAccessor<Format, std::enable_if_t<
+		std::is_same<decltype(Format::toStream(std::declval<const Serialisable::JSON&>(), std::declval<std::ostream&>())), void>::value &&
+		std::is_same<decltype(Format::fromStream(std::declval<std::istream&>())), Serialisable::JSON>::value>> {
+
+	template <typename Internal>
+	static void save(const std::string& fileName, const Internal& source) {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "save " + fileName);
+		save(fileName, source, WritesIntoSink<Format, PipelinedFileWriter>());
+	}
+
+	template <typename Internal>
+	static Internal load(const std::string& fileName) {
+		SERIALISABLE_BY_DUGI_TRACE_SPAN("file", "load " + fileName);
+		return FileLoader<Format, true>::load(fileName);
+	}
+
+private:
+	static void save(const std::string& fileName, const Serialisable::JSON& source, std::true_type) {
+		FileSaver<Format, true>::save(fileName, source);
+	}
+
+	static void save(const std::string& fileName, const Serialisable::JSON& source, std::false_type) {
+		std::ofstream stream(fileName, std::ios::binary);
+		Format::toStream(source, stream);
+		stream.close();
+		if (stream.fail())
+			throw std::runtime_error("Could not write " + fileName);
+	}
+};
+
+inline void Tracing::save(const std::string& fileName) {
+	Serialisable::JSON made;
+	Serialisable::JSON::ArrayType& events = made.setObject()["traceEvents"].setArray();
+	std::vector<std::shared_ptr<ThreadEvents>> threads;
+	{
+		// Saving opens spans and may start a thread, both register threads, so the registry can't stay locked
+		Registry& shared = registry();
+		std::lock_guard<std::mutex> lock(shared.lock);
+		threads = shared.threads;
+	}
+	for (auto& thread : threads) {
+		std::lock_guard<std::mutex> threadLock(thread->lock);
+		for (auto& it : thread->events) {
+			Serialisable::JSON event;
+			Serialisable::JSON::ObjectType& object = event.setObject();
+			object["name"] = it.name;
+			object["cat"] = it.category;
+			object["ph"] = "X"; // Complete event, with start and duration
+			object["ts"] = it.start / 1000.0; // In microseconds
+			object["dur"] = it.duration / 1000.0;
+			object["pid"] = 1;
+			object["tid"] = thread->thread;
+			events.push_back(event);
+		}
+	}
+	struct Exporting {
+		Exporting() { exporting() = true; }
+		~Exporting() { exporting() = false; }
+	} exportingScope;
+	made.save(fileName);
+}
+}
+
+inline std::string Serialisable::JSON::toString() const {
+	return to<SerialisableInternals::JSONformat>();
+}
+
+inline Serialisable::JSON Serialisable::JSON::fromString(const std::string& source) {
+	return from<SerialisableInternals::JSONformat>(source);
+}
+
+inline void Serialisable::JSON::save(const std::string& fileName) const {
+	saveAs<SerialisableInternals::JSONformat>(fileName);
+}
+
+inline Serialisable::JSON Serialisable::JSON::load(const std::string& fileName) {
+	return loadAs<SerialisableInternals::JSONformat>(fileName);
+}
+
+namespace SerialisableInternals {
+template <typename Serialised>
+struct Serialiser<Serialised, std::enable_if_t<std::is_integral<Serialised>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an arithmetic integer value
+	* \param The value
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(Serialised value) {
+		return Serialisable::JSON(value);
 	}
 	/*!
 	* \brief Loads an arithmetic integer value
@@ -1257,165 +2963,874 @@ struct Serialiser<std::string, void> {
 		return Serialisable::JSON(value);
 	}
 	/*!
-	* \brief Loads a string value
+	* \brief Loads a string value
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::string& result, const Serialisable::JSON& value) {
+		result = value.string();
+	}
+};
+
+template <>
+struct Serialiser<std::vector<uint8_t>, void> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a binary value expressed as a vector of uint8_t with base64 encoding to string
+	* \param The value
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(const std::vector<uint8_t>& value) {
+		return Serialisable::JSON(Serialisable::toBase64(value));
+	}
+	/*!
+	* \brief Loads a string value
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::vector<uint8_t>& result, const Serialisable::JSON& value) {
+		result = Serialisable::fromBase64(value.string());
+	}
+};
+
+template <typename Enum>
+struct EnumName {
+	Enum value;
+	const char* name;
+};
+
+// Specialise with a constexpr static method names() returning std::array<EnumName<Enum>, N> to save the enum by names
+template <typename Enum>
+struct EnumNames { };
+
+template <typename Enum, typename SFINAE = void>
+struct HasEnumNames : std::false_type { };
+
+template <typename Enum>
+struct HasEnumNames<Enum, decltype(void(EnumNames<Enum>::names()))> : std::true_type { };
+
+// Lookup tables between values and names of an enum with EnumNames specialised, built at compile time
+template <typename Enum>
+class EnumNameTable {
+	using Underlying = std::underlying_type_t<Enum>;
+	using Entries = decltype(EnumNames<Enum>::names());
+	constexpr static size_t N = std::tuple_size<Entries>::value;
+	constexpr static size_t DIRECT = 2 * N + 8; // Values spanning a range up to this size are indexed directly
+
+	NameHash<N> _hash;
+	Underlying _values[N > 0 ? N : 1];
+	Underlying _minimum;
+	bool _direct;
+	int _byValue[DIRECT]; // Index of the name for each value from the minimum, if indexed directly
+	size_t _sorted[N > 0 ? N : 1]; // Indexes of the names sorted by value otherwise
+
+	template <size_t... indexes>
+	constexpr static std::array<const char*, N> namesOf(const Entries& entries, std::index_sequence<indexes...>) {
+		return {{ entries[indexes].name... }};
+	}
+
+public:
+	constexpr EnumNameTable() : _hash(namesOf(EnumNames<Enum>::names(), std::make_index_sequence<N>())),
+			_values(), _minimum(), _direct(), _byValue(), _sorted() {
+		const Entries entries = EnumNames<Enum>::names();
+		Underlying maximum = 0;
+		for (size_t i = 0; i < N; i++) {
+			_values[i] = Underlying(entries[i].value);
+			if (i == 0 || _values[i] < _minimum)
+				_minimum = _values[i];
+			if (i == 0 || _values[i] > maximum)
+				maximum = _values[i];
+		}
+		_direct = (N > 0 && uint64_t(maximum) - uint64_t(_minimum) < DIRECT);
+		for (size_t i = 0; i < DIRECT; i++)
+			_byValue[i] = -1;
+		for (size_t i = 0; i < N; i++) {
+			if (_direct) {
+				int& slot = _byValue[uint64_t(_values[i]) - uint64_t(_minimum)];
+				if (slot == -1)
+					slot = int(i); // Aliases are written with the first name
+			}
+			size_t position = i; // Insertion sort, stable so that the first alias is found first
+			while (position > 0 && _values[_sorted[position - 1]] > _values[i]) {
+				_sorted[position] = _sorted[position - 1];
+				position--;
+			}
+			_sorted[position] = i;
+		}
+	}
+
+	/*!
+	* \brief Finds the name of a value
+	* \param The value
+	* \return The name, nullptr if the value has none
+	*/
+	constexpr const char* name(Enum value) const {
+		Underlying number = Underlying(value);
+		if (_direct) {
+			if (number < _minimum || uint64_t(number) - uint64_t(_minimum) >= DIRECT)
+				return nullptr;
+			int index = _byValue[uint64_t(number) - uint64_t(_minimum)];
+			return index < 0 ? nullptr : _hash.name(size_t(index));
+		}
+		size_t low = 0;
+		size_t high = N;
+		while (low < high) {
+			size_t middle = (low + high) / 2;
+			if (_values[_sorted[middle]] < number)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return (low < N && _values[_sorted[low]] == number) ? _hash.name(_sorted[low]) : nullptr;
+	}
+
+	/*!
+	* \brief Finds the value with the name held by a JSON string
+	* \param Reference to the result
+	* \param The JSON
+	* \return If the name was found
+	* \throw If it's not a string
+	*/
+	bool find(Enum& result, const Serialisable::JSON& value) const {
+		int index = _hash.find(value);
+		if (index < 0)
+			return false;
+		result = Enum(_values[index]);
+		return true;
+	}
+};
+
+template <typename Serialised>
+struct Serialiser<Serialised, std::enable_if_t<std::is_enum<Serialised>::value && HasEnumNames<Serialised>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an enum as its name, or as integer if it has no name or the format is binary
+	* \param The value
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(Serialised value) {
+		if (!BinaryTarget::active()) {
+			const char* name = table().name(value);
+			if (name)
+				return Serialisable::JSON(name);
+		}
+		return Serialisable::JSON(std::underlying_type_t<Serialised>(value));
+	}
+	/*!
+	* \brief Loads an enum from its name or from integer
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong or the name is unknown
+	*/
+	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
+		if (value.type() == Serialisable::JSON::Type::NUMBER)
+			result = Serialised(std::underlying_type_t<Serialised>(value.number()));
+		else if (!table().find(result, value))
+			throw Serialisable::SerialisationError("Unknown enum value name: " + value.string());
+	}
+
+private:
+	static const EnumNameTable<Serialised>& table() {
+		static constexpr EnumNameTable<Serialised> made = {};
+		return made;
+	}
+};
+
+template <typename Serialised>
+struct Serialiser<Serialised, std::enable_if_t<std::is_enum<Serialised>::value && !HasEnumNames<Serialised>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an enum as integer
+	* \param The value
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(Serialised value) {
+		return Serialisable::JSON(std::underlying_type_t<Serialised>(value));
+	}
+	/*!
+	* \brief Loads an integer as enum
+	* \param The JSON
+	* \return The value
+	* \throw If the type is wrong
+	*/
+	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
+		result = Serialised(value.number());
+	}
+};
+
+template <>
+struct Serialiser<bool, void> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a boolean value
+	* \param The value
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(bool value) {
+		return Serialisable::JSON(value);
+	}
+	/*!
+	* \brief Loads a boolean value
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(bool& result, const Serialisable::JSON& value) {
+		result = value.boolean();
+	}
+};
+
+struct UnusualSerialisable { }; // Inherit from this to avoid using the following serialisation choice
+
+template <typename Serialised>
+struct Serialiser<Serialised, std::enable_if_t<std::is_base_of<Serialisable, Serialised>::value
+		&& !std::is_base_of<UnusualSerialisable, Serialised>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an object of a class derived from Serialisable as JSON
+	* \param The object
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(const Serialised& value) {
+		return value.toJSON();
+	}
+	/*!
+	* \brief Loads JSON into an object of a class derived from Serialisable
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the something's wrong with the JSON
+	*/
+	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
+		result.fromJSON(value);
+	}
+};
+
+// Lets containers deserialise their elements on more threads if this thread allowed it, see serialisable_parallel.hpp
+struct ParallelElements {
+	// Calls the function on ranges covering indexes from 0 to count, returns false if it should be done in this thread instead
+	using Runner = bool (*)(size_t count, void (*function)(void* context, size_t begin, size_t end), void* context);
+
+	static Runner& runner() {
+		thread_local Runner instance = nullptr;
+		return instance;
+	}
+
+	// Only serialisable objects are worth it, shared objects must be found in the order they were saved
+	template <typename T, typename Function>
+	static bool run(size_t count, Function function) {
+		Runner active = runner();
+		if (!std::is_base_of<ISerialisable, T>::value || !active || SharedObjectTracking::current())
+			return false;
+		return active(count, [] (void* context, size_t begin, size_t end) {
+			(*static_cast<Function*>(context))(begin, end);
+		}, &function);
+	}
+};
+
+template <typename T>
+struct Serialiser<std::vector<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a vector of serialisable values
+	* \param The vector
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(const std::vector<T>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(value.size());
+		for (unsigned int i = 0; i < value.size(); i++)
+			array.push_back(Serialiser<T, void>::serialise(value[i]));
+		return made;
+	}
+	/*!
+	* \brief Loads a vector of serialisable values
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::vector<T>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+		result.resize(got.size());
+		if (ParallelElements::run<T>(got.size(), [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				Serialiser<T, void>::deserialise(result[i], got[i]);
+		}))
+			return;
+		for (unsigned int i = 0; i < got.size(); i++)
+			Serialiser<T, void>::deserialise(result[i], got[i]);
+	}
+};
+
+template <typename T>
+struct Serialiser<std::unordered_map<std::string, T>, std::enable_if_t<Serialiser<T, void>::valid>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a hashtable of serialisable values
+	* \param The vector
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(const std::unordered_map<std::string, T>& value) {
+		Serialisable::JSON made;
+		made.setObject().reserve(value.size());
+		for (auto& it : value)
+			made[it.first] = Serialiser<T, void>::serialise(it.second);
+		return made;
+	}
+	/*!
+	* \brief Loads a hashtable of serialisable values
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::unordered_map<std::string, T>& result, const Serialisable::JSON& value) {
+		const auto& got = value.object();
+		for (auto it = result.begin(); it != result.end(); ) {
+			if (got.find(it->first) == got.end())
+				it = result.erase(it);
+			else
+				++it;
+		}
+		if (got.size() > result.bucket_count() * result.max_load_factor())
+			result.reserve(got.size()); // Reserving less than the current capacity could shrink it
+		if (std::is_base_of<ISerialisable, T>::value && ParallelElements::runner()) {
+			std::vector<std::pair<T*, const Serialisable::JSON*>> entries; // The entries are created first, only filling them can be parallel
+			entries.reserve(got.size());
+			for (auto& it : got)
+				entries.emplace_back(&result[it.first], &it.second);
+			if (ParallelElements::run<T>(entries.size(), [&] (size_t begin, size_t end) {
+				for (size_t i = begin; i < end; i++)
+					Serialiser<T, void>::deserialise(*entries[i].first, *entries[i].second);
+			}))
+				return;
+			for (auto& it : entries)
+				Serialiser<T, void>::deserialise(*it.first, *it.second);
+			return;
+		}
+		for (auto& it : got)
+			Serialiser<T, void>::deserialise(result[it.first], it.second);
+	}
+};
+
+/*!
+* \brief Loads sorted keys and values into an ordered map, reusing the entries already present
+* \param The map
+* \param Keys with JSONs of their values, sorted by key, keys are moved from
+* \throw If a value can't be deserialised
+*/
+template <typename Key, typename T>
+void mergeIntoMap(std::map<Key, T>& result, std::vector<std::pair<Key, const Serialisable::JSON*>>& sorted) {
+#if __cplusplus > 201402L
+	std::vector<typename std::map<Key, T>::node_type> unused; // Nodes of removed keys are reused for new keys
+#endif
+	auto position = result.begin();
+	for (auto& it : sorted) {
+		while (position != result.end() && position->first < it.first) {
+#if __cplusplus > 201402L
+			unused.push_back(result.extract(position++));
+#else
+			position = result.erase(position);
+#endif
+		}
+		if (position != result.end() && position->first == it.first) {
+			Serialiser<T, void>::deserialise(position->second, *it.second);
+			++position;
+			continue;
+		}
+#if __cplusplus > 201402L
+		if (!unused.empty()) {
+			auto node = std::move(unused.back());
+			unused.pop_back();
+			node.key() = std::move(it.first);
+			T made; // The node's value belonged to another key, members absent from the JSON must not keep its values
+			Serialiser<T, void>::deserialise(made, *it.second);
+			node.mapped() = std::move(made);
+			result.insert(position, std::move(node));
+			continue;
+		}
+#endif
+		auto inserted = result.emplace_hint(position, std::move(it.first), T());
+		Serialiser<T, void>::deserialise(inserted->second, *it.second);
+	}
+	result.erase(position, result.end());
+}
+
+template <typename T>
+struct Serialiser<std::map<std::string, T>, std::enable_if_t<Serialiser<T, void>::valid>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an ordered map of serialisable values
+	* \param The map
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(const std::map<std::string, T>& value) {
+		Serialisable::JSON made;
+		made.setObject().reserve(value.size());
+		for (auto& it : value)
+			made[it.first] = Serialiser<T, void>::serialise(it.second);
+		return made;
+	}
+	/*!
+	* \brief Loads an ordered map of serialisable values
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	* \note Keys are sorted first, so that they can be merged with the existing contents using hints
+	*/
+	static void deserialise(std::map<std::string, T>& result, const Serialisable::JSON& value) {
+		const auto& got = value.object();
+		std::vector<std::pair<std::string, const Serialisable::JSON*>> sorted;
+		sorted.reserve(got.size());
+		for (auto& it : got)
+			sorted.emplace_back(it.first, &it.second);
+		std::sort(sorted.begin(), sorted.end(), [] (const auto& first, const auto& second) {
+			return first.first < second.first;
+		});
+		mergeIntoMap(result, sorted);
+	}
+};
+
+// Conversions of integer and enum map keys, written as decimal strings in text and as numbers in binary formats
+template <typename Key>
+struct NumericKey {
+	using Number = typename std::conditional_t<std::is_enum<Key>::value, std::underlying_type<Key>, std::common_type<Key>>::type;
+	constexpr static int MAX_DIGITS = std::numeric_limits<Number>::digits10 + 3; // Sign, rounding and terminator
+	constexpr static uint64_t MAX_EXACT = 1ull << std::numeric_limits<double>::digits; // Larger numbers can't be exact in JSON
+	constexpr static bool ALWAYS_EXACT = std::numeric_limits<Number>::digits <= std::numeric_limits<double>::digits;
+
+	static bool exact(Key key) {
+		if (ALWAYS_EXACT)
+			return true;
+		Number number = Number(key);
+		return number >= 0 ? uint64_t(number) <= MAX_EXACT : uint64_t(-(number + 1)) < MAX_EXACT;
+	}
+
+	// Writes the digits to the end of the buffer, returns where they start
+	static char* toText(Key key, char* bufferEnd) {
+		Number number = Number(key);
+		bool negative = number < 0;
+		using Unsigned = std::make_unsigned_t<Number>;
+		Unsigned magnitude = negative ? Unsigned(0) - Unsigned(number) : Unsigned(number);
+		char* position = bufferEnd;
+		*--position = '\0';
+		do {
+			*--position = char('0' + magnitude % 10);
+			magnitude /= 10;
+		} while (magnitude);
+		if (negative)
+			*--position = '-';
+		return position;
+	}
+
+	static Key fromText(const std::string& text) {
+		using Unsigned = std::make_unsigned_t<Number>;
+		size_t position = 0;
+		bool negative = false;
+		if (std::is_signed<Number>::value && !text.empty() && text[0] == '-') {
+			negative = true;
+			position++;
+		}
+		if (position == text.size() || text.size() - position > size_t(MAX_DIGITS))
+			throw Serialisable::SerialisationError("Map key is not a valid number: " + text);
+		// The magnitude of the lowest value is larger by one than that of the highest
+		const Unsigned limit = Unsigned(std::numeric_limits<Number>::max()) + (negative ? 1 : 0);
+		Unsigned magnitude = 0;
+		for ( ; position < text.size(); position++) {
+			if (text[position] < '0' || text[position] > '9')
+				throw Serialisable::SerialisationError("Map key is not a valid number: " + text);
+			Unsigned digit = Unsigned(text[position] - '0');
+			if (magnitude > Unsigned((limit - digit) / 10))
+				throw Serialisable::SerialisationError("Map key is out of range: " + text);
+			magnitude = Unsigned(magnitude * 10 + digit);
+		}
+		return Key(negative ? Number(Unsigned(0) - magnitude) : Number(magnitude));
+	}
+
+	static Key fromNumber(const Serialisable::JSON& value) {
+		double number = value.number();
+		// The upper bound is a power of two, so it's exact even where the largest value isn't
+		if (!(number >= double(std::numeric_limits<Number>::lowest()) && number < std::ldexp(1.0, std::numeric_limits<Number>::digits)))
+			throw Serialisable::SerialisationError("Map key is out of range: " + std::to_string(number));
+		if (std::floor(number) != number)
+			throw Serialisable::SerialisationError("Map key is not an integer: " + std::to_string(number));
+		return Key(Number(number));
+	}
+
+	/*!
+	* \brief Saves a map with numeric keys, as an array of alternating keys and values if the target is binary
+	* \param The map
+	* \return The constructed JSON
+	*/
+	template <typename Map>
+	static Serialisable::JSON serialise(const Map& value) {
+		using T = typename Map::mapped_type;
+		Serialisable::JSON made;
+		bool binary = BinaryTarget::active();
+		if (binary && !ALWAYS_EXACT) {
+			for (auto& it : value)
+				if (!exact(it.first)) {
+					binary = false;
+					break;
+				}
+		}
+		if (binary) {
+			Serialisable::JSON::ArrayType& array = made.setArray();
+			array.reserve(value.size() * 2);
+			for (auto& it : value) {
+				array.push_back(Serialisable::JSON(Number(it.first)));
+				array.push_back(Serialiser<T, void>::serialise(it.second));
+			}
+		} else {
+			Serialisable::JSON::ObjectType& object = made.setObject();
+			object.reserve(value.size());
+			char buffer[MAX_DIGITS];
+			for (auto& it : value)
+				object.emplace(toText(it.first, buffer + MAX_DIGITS), Serialiser<T, void>::serialise(it.second));
+		}
+		return made;
+	}
+
+	/*!
+	* \brief Reads the keys of a map saved in either form, sorted by key
+	* \param The JSON
+	* \return Keys with the JSONs of their values
+	* \throw If the type is wrong or a key is not a number
+	*/
+	static std::vector<std::pair<Key, const Serialisable::JSON*>> sortedEntries(const Serialisable::JSON& value) {
+		std::vector<std::pair<Key, const Serialisable::JSON*>> sorted;
+		if (value.type() == Serialisable::JSON::Type::ARRAY) {
+			const std::vector<Serialisable::JSON>& got = value.array();
+			if (got.size() % 2)
+				throw Serialisable::SerialisationError("Map with numeric keys must have a value for each key");
+			sorted.reserve(got.size() / 2);
+			for (size_t i = 0; i < got.size(); i += 2)
+				sorted.emplace_back(fromNumber(got[i]), &got[i + 1]);
+		} else {
+			const auto& got = value.object();
+			sorted.reserve(got.size());
+			for (auto& it : got)
+				sorted.emplace_back(fromText(it.first), &it.second);
+		}
+		std::sort(sorted.begin(), sorted.end(), [] (const auto& first, const auto& second) {
+			return Number(first.first) < Number(second.first);
+		});
+		return sorted;
+	}
+};
+
+template <typename Key>
+constexpr bool isNumericKey() {
+	return (std::is_integral<Key>::value && !std::is_same<Key, bool>::value) || std::is_enum<Key>::value;
+}
+
+template <typename Key, typename T>
+struct Serialiser<std::map<Key, T>, std::enable_if_t<isNumericKey<Key>() && Serialiser<T, void>::valid>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves an ordered map with integer or enum keys
+	* \param The map
+	* \return The constructed JSON
+	* \note Keys are decimal strings in text, binary formats get an array of alternating keys and values
+	*/
+	static Serialisable::JSON serialise(const std::map<Key, T>& value) {
+		return NumericKey<Key>::serialise(value);
+	}
+	/*!
+	* \brief Loads an ordered map with integer or enum keys, in either form
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong or a key is not a number
+	*/
+	static void deserialise(std::map<Key, T>& result, const Serialisable::JSON& value) {
+		auto sorted = NumericKey<Key>::sortedEntries(value);
+		mergeIntoMap(result, sorted);
+	}
+};
+
+template <typename Key, typename T>
+struct Serialiser<std::unordered_map<Key, T>, std::enable_if_t<isNumericKey<Key>() && Serialiser<T, void>::valid>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a hashtable with integer or enum keys
+	* \param The hashtable
+	* \return The constructed JSON
+	* \note Keys are decimal strings in text, binary formats get an array of alternating keys and values
+	*/
+	static Serialisable::JSON serialise(const std::unordered_map<Key, T>& value) {
+		return NumericKey<Key>::serialise(value);
+	}
+	/*!
+	* \brief Loads a hashtable with integer or enum keys, in either form
 	* \param Reference to the result value
 	* \param The JSON
-	* \throw If the type is wrong
+	* \throw If the type is wrong or a key is not a number
 	*/
-	static void deserialise(std::string& result, const Serialisable::JSON& value) {
-		result = value.string();
+	static void deserialise(std::unordered_map<Key, T>& result, const Serialisable::JSON& value) {
+		using Number = typename NumericKey<Key>::Number;
+		auto sorted = NumericKey<Key>::sortedEntries(value);
+		for (auto it = result.begin(); it != result.end(); ) {
+			bool present = std::binary_search(sorted.begin(), sorted.end(), it->first, [] (const auto& first, const auto& second) {
+				return Number(keyOf(first)) < Number(keyOf(second));
+			});
+			if (present)
+				++it;
+			else
+				it = result.erase(it);
+		}
+		if (sorted.size() > result.bucket_count() * result.max_load_factor())
+			result.reserve(sorted.size()); // Reserving less than the current capacity could shrink it
+		for (auto& it : sorted)
+			Serialiser<T, void>::deserialise(result[it.first], *it.second);
+	}
+
+private:
+	static Key keyOf(Key key) {
+		return key;
+	}
+	static Key keyOf(const std::pair<Key, const Serialisable::JSON*>& entry) {
+		return entry.first;
 	}
 };
 
-template <>
-struct Serialiser<std::vector<uint8_t>, void> {
+template <typename T>
+struct Serialiser<std::set<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves a binary value expressed as a vector of uint8_t with base64 encoding to string
-	* \param The value
+	* \brief Saves an ordered set of serialisable values as an array
+	* \param The set
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(const std::vector<uint8_t>& value) {
-		return Serialisable::JSON(Serialisable::toBase64(value));
+	static Serialisable::JSON serialise(const std::set<T>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(value.size());
+		for (auto& it : value)
+			array.push_back(Serialiser<T, void>::serialise(it));
+		return made;
 	}
 	/*!
-	* \brief Loads a string value
+	* \brief Loads an ordered set of serialisable values from an array
 	* \param Reference to the result value
 	* \param The JSON
 	* \throw If the type is wrong
+	* \note Inserting at the end is constant time if the array is sorted, as it is when saved from a set
 	*/
-	static void deserialise(std::vector<uint8_t>& result, const Serialisable::JSON& value) {
-		result = Serialisable::fromBase64(value.string());
+	static void deserialise(std::set<T>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+#if __cplusplus > 201402L
+		std::vector<typename std::set<T>::node_type> unused;
+		unused.reserve(result.size());
+		while (!result.empty())
+			unused.push_back(result.extract(result.begin()));
+#else
+		result.clear();
+#endif
+		for (unsigned int i = 0; i < got.size(); i++) {
+			T made; // Not loaded into a reused node's value, members absent from the JSON would keep values of another element
+			Serialiser<T, void>::deserialise(made, got[i]);
+#if __cplusplus > 201402L
+			if (!unused.empty()) {
+				auto node = std::move(unused.back());
+				unused.pop_back();
+				node.value() = std::move(made);
+				result.insert(result.end(), std::move(node));
+				continue;
+			}
+#endif
+			result.emplace_hint(result.end(), std::move(made));
+		}
 	}
 };
 
-template <typename Serialised>
-struct Serialiser<Serialised, std::enable_if_t<std::is_enum<Serialised>::value>> {
+template <typename T>
+struct Serialiser<std::unordered_set<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves an enum as integer
-	* \param The value
+	* \brief Saves a hashset of serialisable values as an array
+	* \param The set
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(Serialised value) {
-		return Serialisable::JSON(std::underlying_type_t<Serialised>(value));
+	static Serialisable::JSON serialise(const std::unordered_set<T>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(value.size());
+		for (auto& it : value)
+			array.push_back(Serialiser<T, void>::serialise(it));
+		return made;
 	}
 	/*!
-	* \brief Loads an integer as enum
+	* \brief Loads a hashset of serialisable values from an array
+	* \param Reference to the result value
 	* \param The JSON
-	* \return The value
 	* \throw If the type is wrong
 	*/
-	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
-		result = Serialised(value.number());
+	static void deserialise(std::unordered_set<T>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+#if __cplusplus > 201402L
+		std::vector<typename std::unordered_set<T>::node_type> unused;
+		unused.reserve(result.size());
+		while (!result.empty())
+			unused.push_back(result.extract(result.begin()));
+#else
+		result.clear();
+#endif
+		if (got.size() > result.bucket_count() * result.max_load_factor())
+			result.reserve(got.size()); // Reserving less than the current capacity could shrink it
+		for (unsigned int i = 0; i < got.size(); i++) {
+			T made; // Not loaded into a reused node's value, members absent from the JSON would keep values of another element
+			Serialiser<T, void>::deserialise(made, got[i]);
+#if __cplusplus > 201402L
+			if (!unused.empty()) {
+				auto node = std::move(unused.back());
+				unused.pop_back();
+				node.value() = std::move(made);
+				result.insert(std::move(node));
+				continue;
+			}
+#endif
+			result.insert(std::move(made));
+		}
 	}
 };
 
-template <>
-struct Serialiser<bool, void> {
+template <typename T>
+struct Serialiser<std::deque<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves a boolean value
-	* \param The value
+	* \brief Saves a deque of serialisable values
+	* \param The deque
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(bool value) {
-		return Serialisable::JSON(value);
+	static Serialisable::JSON serialise(const std::deque<T>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(value.size());
+		for (auto& it : value)
+			array.push_back(Serialiser<T, void>::serialise(it));
+		return made;
 	}
 	/*!
-	* \brief Loads a boolean value
+	* \brief Loads a deque of serialisable values
 	* \param Reference to the result value
 	* \param The JSON
 	* \throw If the type is wrong
 	*/
-	static void deserialise(bool& result, const Serialisable::JSON& value) {
-		result = value.boolean();
+	static void deserialise(std::deque<T>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+		result.resize(got.size());
+		if (ParallelElements::run<T>(got.size(), [&] (size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				Serialiser<T, void>::deserialise(result[i], got[i]);
+		}))
+			return;
+		for (unsigned int i = 0; i < got.size(); i++)
+			Serialiser<T, void>::deserialise(result[i], got[i]);
 	}
 };
 
-struct UnusualSerialisable { }; // Inherit from this to avoid using the following serialisation choice
-
-template <typename Serialised>
-struct Serialiser<Serialised, std::enable_if_t<std::is_base_of<Serialisable, Serialised>::value
-		&& !std::is_base_of<UnusualSerialisable, Serialised>::value>> {
+template <typename T>
+struct Serialiser<std::list<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves an object of a class derived from Serialisable as JSON
-	* \param The object
+	* \brief Saves a list of serialisable values
+	* \param The list
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(const Serialised& value) {
-		return value.toJSON();
+	static Serialisable::JSON serialise(const std::list<T>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(value.size());
+		for (auto& it : value)
+			array.push_back(Serialiser<T, void>::serialise(it));
+		return made;
 	}
 	/*!
-	* \brief Loads JSON into an object of a class derived from Serialisable
+	* \brief Loads a list of serialisable values, reusing the existing elements
 	* \param Reference to the result value
 	* \param The JSON
-	* \throw If the something's wrong with the JSON
+	* \throw If the type is wrong
 	*/
-	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
-		result.fromJSON(value);
+	static void deserialise(std::list<T>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+		result.resize(got.size());
+		unsigned int i = 0;
+		for (auto& it : result)
+			Serialiser<T, void>::deserialise(it, got[i++]);
 	}
 };
 
-template <typename T>
-struct Serialiser<std::vector<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
+template <typename First, typename Second>
+struct Serialiser<std::pair<First, Second>, std::enable_if_t<Serialiser<First, void>::valid && Serialiser<Second, void>::valid>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves a vector of serialisable values
-	* \param The vector
+	* \brief Saves a pair of serialisable values as an array of two elements
+	* \param The pair
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(const std::vector<T>& value) {
-		auto made = Serialisable::JSON(Serialisable::JSON::ArrayType(value.size()));
-		for (unsigned int i = 0; i < value.size(); i++)
-			made[i] = Serialiser<T, void>::serialise(value[i]);
+	static Serialisable::JSON serialise(const std::pair<First, Second>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(2);
+		array.push_back(Serialiser<First, void>::serialise(value.first));
+		array.push_back(Serialiser<Second, void>::serialise(value.second));
 		return made;
 	}
 	/*!
-	* \brief Loads a vector of serialisable values
+	* \brief Loads a pair of serialisable values from an array of two elements
 	* \param Reference to the result value
 	* \param The JSON
-	* \throw If the type is wrong
+	* \throw If the type is wrong or the array is too short
 	*/
-	static void deserialise(std::vector<T>& result, const Serialisable::JSON& value) {
+	static void deserialise(std::pair<First, Second>& result, const Serialisable::JSON& value) {
 		const std::vector<Serialisable::JSON>& got = value.array();
-		result.resize(got.size());
-		for (unsigned int i = 0; i < got.size(); i++)
-			Serialiser<T, void>::deserialise(result[i], got[i]);
+		if (got.size() < 2)
+			throw Serialisable::SerialisationError("Pair must be stored as an array of two elements");
+		Serialiser<First, void>::deserialise(result.first, got[0]);
+		Serialiser<Second, void>::deserialise(result.second, got[1]);
 	}
 };
 
-template <typename T>
-struct Serialiser<std::unordered_map<std::string, T>, std::enable_if_t<Serialiser<T, void>::valid>> {
+template <typename... Ts>
+struct Serialiser<std::tuple<Ts...>, std::enable_if_t<std::is_same<std::integer_sequence<bool, true, Serialiser<Ts, void>::valid...>,
+		std::integer_sequence<bool, Serialiser<Ts, void>::valid..., true>>::value>> {
 	constexpr static bool valid = true;
 	/*!
-	* \brief Saves a hashtable of serialisable values
-	* \param The vector
+	* \brief Saves a tuple of serialisable values as an array
+	* \param The tuple
 	* \return The constructed JSON
 	*/
-	static Serialisable::JSON serialise(const std::unordered_map<std::string, T>& value) {
-		auto made = Serialisable::JSON(Serialisable::JSON::ObjectType(value.size() * 1.5));
-		for (auto& it : value)
-			made[it.first] = Serialiser<T, void>::serialise(it.second);
+	static Serialisable::JSON serialise(const std::tuple<Ts...>& value) {
+		Serialisable::JSON made;
+		Serialisable::JSON::ArrayType& array = made.setArray();
+		array.reserve(sizeof...(Ts));
+		serialiseElements(value, array, std::index_sequence_for<Ts...>());
 		return made;
 	}
 	/*!
-	* \brief Loads a hashtable of serialisable values
+	* \brief Loads a tuple of serialisable values from an array
 	* \param Reference to the result value
 	* \param The JSON
-	* \throw If the type is wrong
+	* \throw If the type is wrong or the array is too short
 	*/
-	static void deserialise(std::unordered_map<std::string, T>& result, const Serialisable::JSON& value) {
-		const auto& got = value.object();
-		for (auto it = result.begin(); it != result.end(); ) {
-			if (got.find(it->first) == got.end())
-				it = result.erase(it);
-			else
-				++it;
-		}
-		for (auto& it : got)
-			Serialiser<T, void>::deserialise(result[it.first], it.second);
+	static void deserialise(std::tuple<Ts...>& result, const Serialisable::JSON& value) {
+		const std::vector<Serialisable::JSON>& got = value.array();
+		if (got.size() < sizeof...(Ts))
+			throw Serialisable::SerialisationError("Tuple must be stored as an array with an element for each of its members");
+		deserialiseElements(result, got, std::index_sequence_for<Ts...>());
+	}
+
+private:
+	template <size_t... indexes>
+	static void serialiseElements(const std::tuple<Ts...>& value, Serialisable::JSON::ArrayType& array, std::index_sequence<indexes...>) {
+		int expander[] = { 0, (array.push_back(Serialiser<Ts, void>::serialise(std::get<indexes>(value))), 0)... };
+		(void)expander;
+	}
+	template <size_t... indexes>
+	static void deserialiseElements(std::tuple<Ts...>& result, const std::vector<Serialisable::JSON>& got, std::index_sequence<indexes...>) {
+		int expander[] = { 0, (Serialiser<Ts, void>::deserialise(std::get<indexes>(result), got[indexes]), 0)... };
+		(void)expander;
 	}
 };
 
@@ -1428,10 +3843,14 @@ struct Serialiser<std::shared_ptr<T>, std::enable_if_t<Serialiser<T, void>::vali
 	* \return The constructed JSON
 	*/
 	static Serialisable::JSON serialise(const std::shared_ptr<T>& value) {
-		if (value)
-			return Serialiser<T, void>::serialise(*value);
-		else
+		if (!value)
 			return Serialisable::JSON(); // null
+		SharedObjectTracking* tracking = SharedObjectTracking::current();
+		if (tracking)
+			return tracking->save(value.get(), [&] () {
+				return Serialiser<T, void>::serialise(*value);
+			}, std::is_base_of<Serialisable, T>::value);
+		return Serialiser<T, void>::serialise(*value);
 	}
 	/*!
 	* \brief Loads a shared pointer to a serialisable value
@@ -1440,7 +3859,12 @@ struct Serialiser<std::shared_ptr<T>, std::enable_if_t<Serialiser<T, void>::vali
 	* \throw If the type is wrong
 	*/
 	static void deserialise(std::shared_ptr<T>& result, const Serialisable::JSON& value) {
-		if (value && value.type() != Serialisable::JSON::Type::NIL) {
+		SharedObjectTracking* tracking = SharedObjectTracking::current();
+		if (tracking && value.type() == Serialisable::JSON::Type::OBJECT) {
+			tracking->load(result, value, [] (T& loaded, const Serialisable::JSON& contents) {
+				Serialiser<T, void>::deserialise(loaded, contents);
+			});
+		} else if (value && value.type() != Serialisable::JSON::Type::NIL) {
 			if (!result)
 				result = std::make_shared<T>();
 			Serialiser<T, void>::deserialise(*result, value);
@@ -1509,6 +3933,326 @@ struct Serialiser<Serialisable::JSON, void> {
 	}
 };
 
+// Conversions between calendar dates and days since 1970-01-01, using Howard Hinnant's algorithms
+struct CivilCalendar {
+	static int64_t daysFromCivil(int64_t year, unsigned int month, unsigned int day) {
+		year -= month <= 2;
+		const int64_t era = (year >= 0 ? year : year - 399) / 400;
+		const unsigned int yearOfEra = unsigned(year - era * 400);
+		const unsigned int dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+		const unsigned int dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+		return era * 146097 + int64_t(dayOfEra) - 719468;
+	}
+
+	static void civilFromDays(int64_t days, int64_t& year, unsigned int& month, unsigned int& day) {
+		days += 719468;
+		const int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+		const unsigned int dayOfEra = unsigned(days - era * 146097);
+		const unsigned int yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+		const unsigned int dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+		const unsigned int shiftedMonth = (5 * dayOfYear + 2) / 153;
+		day = dayOfYear - (153 * shiftedMonth + 2) / 5 + 1;
+		month = shiftedMonth < 10 ? shiftedMonth + 3 : shiftedMonth - 9;
+		year = int64_t(yearOfEra) + era * 400 + (month <= 2);
+	}
+};
+
+// Integer tick counts that may not fit into a double are written as decimal strings
+struct ExactCount {
+	constexpr static int64_t MAX_EXACT = int64_t(1) << std::numeric_limits<double>::digits;
+
+	template <typename Rep, std::enable_if_t<std::is_integral<Rep>::value>* = nullptr>
+	static Serialisable::JSON serialise(Rep count) {
+		if (count <= Rep(MAX_EXACT) && (std::is_unsigned<Rep>::value || int64_t(count) >= -MAX_EXACT))
+			return Serialisable::JSON(count);
+		return Serialisable::JSON(std::to_string(count));
+	}
+	template <typename Rep, std::enable_if_t<!std::is_integral<Rep>::value>* = nullptr>
+	static Serialisable::JSON serialise(Rep count) {
+		return Serialisable::JSON(count);
+	}
+
+	template <typename Rep, std::enable_if_t<std::is_integral<Rep>::value>* = nullptr>
+	static Rep deserialise(const Serialisable::JSON& value) {
+		if (value.type() != Serialisable::JSON::Type::STRING) {
+			double number = value.number();
+			// The upper bound is a power of two, so it's exact even where the largest value isn't
+			if (!(number >= double(std::numeric_limits<Rep>::lowest()) && number < std::ldexp(1.0, std::numeric_limits<Rep>::digits)))
+				throw Serialisable::SerialisationError("Time count is out of range: " + std::to_string(number));
+			return Rep(number);
+		}
+		std::string text = value.string();
+		bool negative = std::is_signed<Rep>::value && !text.empty() && text[0] == '-';
+		size_t position = negative ? 1 : 0;
+		if (position == text.size())
+			throw Serialisable::SerialisationError("Invalid time count: " + text);
+		using Unsigned = std::make_unsigned_t<Rep>;
+		// The magnitude of the lowest value is larger by one than that of the highest
+		const Unsigned limit = Unsigned(std::numeric_limits<Rep>::max()) + (negative ? 1 : 0);
+		Unsigned magnitude = 0;
+		for (size_t i = position; i < text.size(); i++) {
+			if (text[i] < '0' || text[i] > '9')
+				throw Serialisable::SerialisationError("Invalid time count: " + text);
+			Unsigned digit = Unsigned(text[i] - '0');
+			if (magnitude > Unsigned((limit - digit) / 10))
+				throw Serialisable::SerialisationError("Time count is out of range: " + text);
+			magnitude = Unsigned(magnitude * 10 + digit);
+		}
+		return negative ? Rep(Unsigned(0) - magnitude) : Rep(magnitude);
+	}
+	template <typename Rep, std::enable_if_t<!std::is_integral<Rep>::value>* = nullptr>
+	static Rep deserialise(const Serialisable::JSON& value) {
+		return Rep(value.number());
+	}
+};
+
+template <typename Rep, typename Period>
+struct Serialiser<std::chrono::duration<Rep, Period>, std::enable_if_t<std::is_arithmetic<Rep>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a duration as the number of its ticks
+	* \param The duration
+	* \return The constructed JSON
+	* \note Counts too large to be exact in a double are saved as decimal strings
+	*/
+	static Serialisable::JSON serialise(std::chrono::duration<Rep, Period> value) {
+		return ExactCount::serialise(value.count());
+	}
+	/*!
+	* \brief Loads a duration from the number of its ticks
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::chrono::duration<Rep, Period>& result, const Serialisable::JSON& value) {
+		result = std::chrono::duration<Rep, Period>(ExactCount::deserialise<Rep>(value));
+	}
+};
+
+template <typename Clock, typename Duration>
+struct Serialiser<std::chrono::time_point<Clock, Duration>, std::enable_if_t<!std::is_same<Clock, std::chrono::system_clock>::value
+		|| !std::is_integral<typename Duration::rep>::value>> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves a time point of a clock other than system clock as the duration since its epoch
+	* \param The time point
+	* \return The constructed JSON
+	*/
+	static Serialisable::JSON serialise(std::chrono::time_point<Clock, Duration> value) {
+		return Serialiser<Duration, void>::serialise(value.time_since_epoch());
+	}
+	/*!
+	* \brief Loads a time point of a clock other than system clock from the duration since its epoch
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong
+	*/
+	static void deserialise(std::chrono::time_point<Clock, Duration>& result, const Serialisable::JSON& value) {
+		Duration sinceEpoch;
+		Serialiser<Duration, void>::deserialise(sinceEpoch, value);
+		result = std::chrono::time_point<Clock, Duration>(sinceEpoch);
+	}
+};
+
+template <typename Duration>
+struct Serialiser<std::chrono::time_point<std::chrono::system_clock, Duration>, std::enable_if_t<std::is_integral<typename Duration::rep>::value>> {
+	constexpr static bool valid = true;
+	using TimePoint = std::chrono::time_point<std::chrono::system_clock, Duration>;
+	using Seconds = std::chrono::duration<int64_t>;
+	using Nanoseconds = std::chrono::duration<int64_t, std::nano>;
+
+	// Enough decimal places to show the duration's precision, up to nanoseconds
+	constexpr static int fractionDigits(intmax_t ticksPerSecond = Duration::period::den / Duration::period::num, int digits = 0) {
+		return (ticksPerSecond <= 1 || digits == 9) ? digits : fractionDigits((ticksPerSecond + 9) / 10, digits + 1);
+	}
+
+	/*!
+	* \brief Saves a system clock time point as an ISO 8601 UTC date and time, or as ticks since epoch in binary formats
+	* \param The time point
+	* \return The constructed JSON
+	* \note In binary formats, time points whose ticks since epoch can't be exact in a double are saved as [seconds, ticks]
+	*/
+	static Serialisable::JSON serialise(TimePoint value) {
+		int64_t count = int64_t(value.time_since_epoch().count());
+		Seconds seconds = std::chrono::duration_cast<Seconds>(value.time_since_epoch());
+		if (seconds > value.time_since_epoch())
+			seconds -= Seconds(1); // Round down before epoch
+		auto remainder = value.time_since_epoch() - seconds;
+		if (BinaryTarget::active()) {
+			if (count <= ExactCount::MAX_EXACT && count >= -ExactCount::MAX_EXACT)
+				return Serialisable::JSON(count);
+			Serialisable::JSON made;
+			Serialisable::JSON::ArrayType& array = made.setArray();
+			array.reserve(2);
+			array.push_back(Serialisable::JSON(seconds.count()));
+			array.push_back(Serialisable::JSON(std::chrono::duration_cast<Duration>(remainder).count()));
+			return made;
+		}
+
+		int64_t days = seconds.count() / 86400;
+		int64_t secondOfDay = seconds.count() % 86400;
+		if (secondOfDay < 0) {
+			secondOfDay += 86400;
+			days--;
+		}
+		int64_t year = 0;
+		unsigned int month = 0;
+		unsigned int day = 0;
+		CivilCalendar::civilFromDays(days, year, month, day);
+
+		char buffer[48];
+		char* position = buffer;
+		auto writeDigits = [&] (uint64_t number, int digits) {
+			for (int i = digits - 1; i >= 0; i--) {
+				position[i] = char('0' + number % 10);
+				number /= 10;
+			}
+			position += digits;
+		};
+		if (year < 0) {
+			*position++ = '-';
+			year = -year;
+		}
+		int yearDigits = 4;
+		for (int64_t limit = 10000; year >= limit && yearDigits < 18; limit *= 10)
+			yearDigits++;
+		writeDigits(uint64_t(year), yearDigits);
+		*position++ = '-';
+		writeDigits(month, 2);
+		*position++ = '-';
+		writeDigits(day, 2);
+		*position++ = 'T';
+		writeDigits(uint64_t(secondOfDay / 3600), 2);
+		*position++ = ':';
+		writeDigits(uint64_t(secondOfDay / 60 % 60), 2);
+		*position++ = ':';
+		writeDigits(uint64_t(secondOfDay % 60), 2);
+		constexpr int digits = fractionDigits();
+		if (digits > 0) {
+			*position++ = '.';
+			int64_t nanoseconds = std::chrono::duration_cast<Nanoseconds>(remainder).count();
+			for (int i = digits; i < 9; i++)
+				nanoseconds /= 10;
+			writeDigits(uint64_t(nanoseconds), digits);
+		}
+		*position++ = 'Z';
+		return Serialisable::JSON(std::string(buffer, position));
+	}
+	/*!
+	* \brief Loads a system clock time point from an ISO 8601 date and time or from ticks since epoch
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong or the date is malformed
+	* \note A missing time zone is taken as UTC
+	*/
+	static void deserialise(TimePoint& result, const Serialisable::JSON& value) {
+		if (value.type() == Serialisable::JSON::Type::NUMBER) {
+			result = TimePoint(Duration(typename Duration::rep(value.number())));
+			return;
+		}
+		if (value.type() == Serialisable::JSON::Type::ARRAY) {
+			const std::vector<Serialisable::JSON>& got = value.array();
+			if (got.size() != 2)
+				throw Serialisable::SerialisationError("Time point must be stored as an array of seconds and ticks");
+			result = TimePoint(std::chrono::duration_cast<Duration>(Seconds(int64_t(got[0].number())))
+					+ Duration(typename Duration::rep(got[1].number())));
+			return;
+		}
+
+		std::string text = value.string();
+		size_t position = 0;
+		auto fail = [&] () {
+			throw Serialisable::SerialisationError("Invalid ISO 8601 date and time: " + text);
+		};
+		auto readNumber = [&] (int minDigits, int maxDigits) {
+			int64_t number = 0;
+			int digits = 0;
+			while (position < text.size() && text[position] >= '0' && text[position] <= '9' && digits < maxDigits) {
+				number = number * 10 + (text[position++] - '0');
+				digits++;
+			}
+			if (digits < minDigits)
+				fail();
+			return number;
+		};
+		auto expect = [&] (char separator) {
+			if (position >= text.size() || text[position] != separator)
+				fail();
+			position++;
+		};
+
+		bool negativeYear = (!text.empty() && text[0] == '-');
+		if (negativeYear)
+			position++;
+		int64_t year = readNumber(4, 18);
+		if (negativeYear)
+			year = -year;
+		expect('-');
+		int64_t month = readNumber(2, 2);
+		expect('-');
+		int64_t day = readNumber(2, 2);
+		if (month < 1 || month > 12 || day < 1)
+			fail();
+		bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+		constexpr static int monthLengths[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+		if (day > monthLengths[month - 1] + ((month == 2 && leapYear) ? 1 : 0))
+			fail();
+		int64_t secondOfDay = 0;
+		int64_t nanoseconds = 0;
+		if (position < text.size() && (text[position] == 'T' || text[position] == 't' || text[position] == ' ')) {
+			position++;
+			int64_t hour = readNumber(2, 2);
+			expect(':');
+			int64_t minute = readNumber(2, 2);
+			if (hour > 23 || minute > 59)
+				fail();
+			secondOfDay = hour * 3600 + minute * 60;
+			if (position < text.size() && text[position] == ':') {
+				position++;
+				int64_t second = readNumber(2, 2);
+				if (second > 60) // A leap second is allowed
+					fail();
+				secondOfDay += second;
+				if (position < text.size() && (text[position] == '.' || text[position] == ',')) {
+					position++;
+					int digits = 0;
+					while (position < text.size() && text[position] >= '0' && text[position] <= '9') {
+						if (digits < 9) {
+							nanoseconds = nanoseconds * 10 + (text[position] - '0');
+							digits++;
+						}
+						position++;
+					}
+					if (!digits)
+						fail();
+					for ( ; digits < 9; digits++)
+						nanoseconds *= 10;
+				}
+			}
+			if (position < text.size()) {
+				if (text[position] == 'Z' || text[position] == 'z') {
+					position++;
+				} else if (text[position] == '+' || text[position] == '-') {
+					int64_t sign = (text[position++] == '-') ? -1 : 1;
+					int64_t offsetHours = readNumber(2, 2);
+					if (position < text.size() && text[position] == ':')
+						position++;
+					int64_t offsetMinutes = readNumber(2, 2);
+					if (offsetHours > 23 || offsetMinutes > 59)
+						fail();
+					secondOfDay -= sign * (offsetHours * 3600 + offsetMinutes * 60);
+				}
+			}
+		}
+		if (position != text.size())
+			fail();
+
+		int64_t seconds = CivilCalendar::daysFromCivil(year, unsigned(month), unsigned(day)) * 86400 + secondOfDay;
+		result = TimePoint(std::chrono::duration_cast<Duration>(Seconds(seconds))
+				+ std::chrono::duration_cast<Duration>(Nanoseconds(nanoseconds)));
+	}
+};
+
 #if __cplusplus > 201402L
 template <typename T>
 struct Serialiser<std::optional<T>, std::enable_if_t<Serialiser<T, void>::valid>> {
@@ -1539,6 +4283,140 @@ struct Serialiser<std::optional<T>, std::enable_if_t<Serialiser<T, void>::valid>
 			result = std::nullopt;
 	}
 };
+
+// Specialise this with a constexpr static const char* name to identify the type as an alternative of std::variant
+// Alternatives without names are identified by their index
+template <typename T, typename SFINAE = void>
+struct VariantAlternativeName {
+	constexpr static const char* name = nullptr;
+};
+
+template <>
+struct Serialiser<std::monostate, void> {
+	constexpr static bool valid = true;
+	/*!
+	* \brief Saves the empty alternative of a variant
+	* \return Null
+	*/
+	static Serialisable::JSON serialise(const std::monostate&) {
+		return Serialisable::JSON(); // null
+	}
+	/*!
+	* \brief Loads the empty alternative of a variant
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If it's not null
+	*/
+	static void deserialise(std::monostate&, const Serialisable::JSON& value) {
+		if (value.type() != Serialisable::JSON::Type::NIL)
+			throw Serialisable::SerialisationError("Expected null as std::monostate");
+	}
+};
+
+template <typename... Ts>
+struct Serialiser<std::variant<Ts...>, std::enable_if_t<std::conjunction_v<std::bool_constant<Serialiser<Ts, void>::valid>...>>> {
+	constexpr static bool valid = true;
+	using Variant = std::variant<Ts...>;
+	/*!
+	* \brief Saves a variant as an object with the alternative's name as key, or as [index, value] in binary formats
+	* \param The variant
+	* \return The constructed JSON
+	*
+	* \note Alternatives whose name is shared by another alternative (as when a type is repeated) are identified by their index
+	*/
+	static Serialisable::JSON serialise(const Variant& value) {
+		if (value.valueless_by_exception())
+			return Serialisable::JSON(); // null
+		Serialisable::JSON contents = serialiseIndex(value, std::index_sequence_for<Ts...>());
+		Serialisable::JSON made;
+		if (BinaryTarget::active()) {
+			Serialisable::JSON::ArrayType& array = made.setArray();
+			array.reserve(2);
+			array.push_back(Serialisable::JSON(value.index()));
+			array.push_back(std::move(contents));
+		} else {
+			const char* name = uniqueName(value.index());
+			if (name)
+				made.setObject()[name] = std::move(contents);
+			else
+				made.setObject()[std::to_string(value.index())] = std::move(contents);
+		}
+		return made;
+	}
+	/*!
+	* \brief Loads a variant in either form, deserialising into the existing value if the alternative is the same
+	* \param Reference to the result value
+	* \param The JSON
+	* \throw If the type is wrong or the alternative is unknown
+	*/
+	static void deserialise(Variant& result, const Serialisable::JSON& value) {
+		if (value.type() == Serialisable::JSON::Type::ARRAY) {
+			const std::vector<Serialisable::JSON>& got = value.array();
+			if (got.size() != 2)
+				throw Serialisable::SerialisationError("Variant must be stored as an array of its index and value");
+			double index = got[0].number();
+			if (!(index >= 0 && index < sizeof...(Ts)))
+				throw Serialisable::SerialisationError("Variant alternative index is out of range");
+			deserialiseIndex(result, size_t(index), got[1], std::index_sequence_for<Ts...>());
+		} else {
+			const auto& got = value.object();
+			if (got.size() != 1)
+				throw Serialisable::SerialisationError("Variant must be stored as an object with a single member");
+			const auto& entry = *got.begin();
+			deserialiseIndex(result, alternativeIndex(entry.first), entry.second, std::index_sequence_for<Ts...>());
+		}
+	}
+
+private:
+	// Alternatives are accessed by index, so that a type can be there more than once
+	template <size_t... Is>
+	static Serialisable::JSON serialiseIndex(const Variant& value, std::index_sequence<Is...>) {
+		constexpr static Serialisable::JSON (*serialisers[])(const Variant&) = { &serialiseAlternative<Is>... };
+		return serialisers[value.index()](value);
+	}
+	template <size_t... Is>
+	static void deserialiseIndex(Variant& result, size_t index, const Serialisable::JSON& value, std::index_sequence<Is...>) {
+		constexpr static void (*deserialisers[])(Variant&, const Serialisable::JSON&) = { &deserialiseAlternative<Is>... };
+		deserialisers[index](result, value);
+	}
+	template <size_t I>
+	static Serialisable::JSON serialiseAlternative(const Variant& value) {
+		return Serialiser<std::variant_alternative_t<I, Variant>, void>::serialise(*std::get_if<I>(&value));
+	}
+	template <size_t I>
+	static void deserialiseAlternative(Variant& result, const Serialisable::JSON& value) {
+		auto* existing = std::get_if<I>(&result);
+		if (!existing)
+			existing = &result.template emplace<I>();
+		Serialiser<std::variant_alternative_t<I, Variant>, void>::deserialise(*existing, value);
+	}
+	static const char* uniqueName(size_t index) {
+		constexpr static const char* names[] = { VariantAlternativeName<Ts>::name... };
+		if (!names[index])
+			return nullptr;
+		for (size_t i = 0; i < sizeof...(Ts); i++)
+			if (i != index && names[i] && strcmp(names[i], names[index]) == 0)
+				return nullptr;
+		return names[index];
+	}
+	static size_t alternativeIndex(const Serialisable::JSON::String& key) {
+		for (size_t i = 0; i < sizeof...(Ts); i++) {
+			const char* name = uniqueName(i);
+			if (name && key == name)
+				return i;
+		}
+		std::string text = key;
+		size_t index = 0;
+		for (char letter : text) {
+			if (letter < '0' || letter > '9' || index >= sizeof...(Ts))
+				throw Serialisable::SerialisationError("Unknown variant alternative: " + text);
+			index = index * 10 + size_t(letter - '0');
+		}
+		if (text.empty() || index >= sizeof...(Ts) || uniqueName(index))
+			throw Serialisable::SerialisationError("Unknown variant alternative: " + text);
+		return index;
+	}
+};
 #endif
 }
 
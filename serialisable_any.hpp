@@ -41,56 +41,94 @@ struct ObjectInspector {
 	}
 };
 
-// Partial template specialisation for recursively finding member count, initialising with more and more variables
-template <typename T, typename sfinae, size_t... indexes>
-struct MemberCounter {
-	constexpr static size_t get() {
-		return sizeof...(indexes) - 1;
-	}
-};
+// Checks if T can be initialised with a given number of inspectors, each of them for one member
+template <typename T, typename Indexes, typename sfinae = void>
+struct ConstructibleWithInspectors : std::false_type {};
 
 template <typename T, size_t... indexes>
-struct MemberCounter<T, decltype( T {ObjectInspector<T, indexes>()...} )*, indexes...> {
+struct ConstructibleWithInspectors<T, std::index_sequence<indexes...>, decltype(void( T {ObjectInspector<T, indexes>()...} ))> : std::true_type {};
+
+template <typename T, size_t count>
+constexpr bool constructibleWith() {
+	return ConstructibleWithInspectors<T, std::make_index_sequence<count>>::value;
+}
+
+// Bisection between a count that is known to be constructible and one that is known not to be
+template <typename T, size_t lower, size_t upper, bool done = (upper - lower <= 1)>
+struct MemberCountBisection {
+	constexpr static size_t middle = lower + (upper - lower) / 2;
+	constexpr static size_t value = std::conditional_t<constructibleWith<T, middle>(),
+			MemberCountBisection<T, middle, upper>, MemberCountBisection<T, lower, middle>>::value;
+};
+
+template <typename T, size_t lower, size_t upper>
+struct MemberCountBisection<T, lower, upper, true> {
+	constexpr static size_t value = lower;
+};
+
+// Doubles the count until it's too many, so only a logarithmic number of initialisations is tried
+template <typename T, size_t bound, bool fits = constructibleWith<T, bound>()>
+struct MemberCountSearch {
+	static_assert(bound < (size_t(1) << 20), "Failed to detect the number of members");
+	constexpr static size_t value = MemberCountSearch<T, bound * 2>::value;
+};
+
+template <typename T, size_t bound>
+struct MemberCountSearch<T, bound, false> {
+	constexpr static size_t value = MemberCountBisection<T, bound / 2, bound>::value;
+};
+
+template <typename T, typename sfinae = T*>
+struct MemberCounter {
 	constexpr static size_t get() {
-		return MemberCounter<T, T*, indexes..., sizeof...(indexes)>::get();
+		return MemberCountSearch<T, 1>::value;
 	}
 };
 
 // Calculation of padding, assuming all composite types contain word-sized members
 // True for std::string, smart pointers and all STL containers (NOT std::array)
 // Should use something specialised for all supported types in the final version
-template <size_t previous, size_t size>
-constexpr size_t padded() {
-	constexpr size_t wordSize = sizeof(void*);
-	return (size == 1 || size == 2 || size == 4 || (size == 8 && wordSize == 8)) ?
+constexpr size_t padded(size_t previous, size_t size) {
+	return (size == 1 || size == 2 || size == 4 || (size == 8 && sizeof(void*) == 8)) ?
 			((previous + size) % size == 0 ? previous : previous + size - (previous + size) % size) :
-			((previous + size) % wordSize == 0 ? previous : previous + wordSize - (previous + size) % wordSize);
+			((previous + size) % sizeof(void*) == 0 ? previous : previous + sizeof(void*) - (previous + size) % sizeof(void*));
 }
 
-// Iteration through all elements, the first overload stops the recursion
-template <typename T, size_t offset>
-void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<>) { }
+// Offsets of all members, computed in a loop rather than through recursive instantiations
+template <size_t count>
+struct MemberOffsets {
+	size_t offsets[count + 1]; // The last one is the end of the last member
+};
+
+template <typename T, size_t... indexes>
+constexpr MemberOffsets<sizeof...(indexes)> memberOffsets(std::index_sequence<indexes...>) {
+	const size_t sizes[] = { 0, size_t(memberSize(ObjectGetter<T, indexes>{}))... };
+	MemberOffsets<sizeof...(indexes)> result = {};
+	size_t offset = 0;
+	for (size_t i = 0; i < sizeof...(indexes); i++) {
+		offset = padded(offset, sizes[i + 1]);
+		result.offsets[i] = offset;
+		offset += sizes[i + 1];
+	}
+	result.offsets[sizeof...(indexes)] = offset;
+	return result;
+}
 
-template <typename T, size_t offset, size_t index, size_t... otherIndexes>
-void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<index, otherIndexes...>) {
-	constexpr size_t size = memberSize(ObjectGetter<T, index>{});
-	constexpr size_t paddedOffset = padded<offset, size>();
-	output.array().push_back(serialiseMember(ObjectGetter<T, index>{}, instance, paddedOffset));
-	serialiseMembers<T, paddedOffset + size>(instance, output, std::index_sequence<otherIndexes...>{});
+// Iteration through all elements, in order because the array is appended to
+template <typename T, size_t... indexes>
+void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<indexes...>) {
+	constexpr MemberOffsets<sizeof...(indexes)> layout = memberOffsets<T>(std::index_sequence<indexes...>{});
+	output.array().reserve(sizeof...(indexes));
+	int expanded[] = { 0, (output.array().push_back(serialiseMember(ObjectGetter<T, indexes>{}, instance, layout.offsets[indexes])), 0)... };
+	(void)expanded;
 }
 
 // Same, for deserialisation
-
-// Iteration through all elements, the first overload stops the recursion
-template <typename T, size_t offset>
-void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<>) { }
-
-template <typename T, size_t offset, size_t index, size_t... otherIndexes>
-void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<index, otherIndexes...>) {
-	constexpr size_t size = memberSize(ObjectGetter<T, index>{});
-	constexpr size_t paddedOffset = padded<offset, size>();
-	deserialiseMember(ObjectGetter<T, index>{}, instance, paddedOffset, input[index]);
-	deserialiseMembers<T, paddedOffset + size>(instance, input, std::index_sequence<otherIndexes...>{});
+template <typename T, size_t... indexes>
+void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<indexes...>) {
+	constexpr MemberOffsets<sizeof...(indexes)> layout = memberOffsets<T>(std::index_sequence<indexes...>{});
+	int expanded[] = { 0, (deserialiseMember(ObjectGetter<T, indexes>{}, instance, layout.offsets[indexes], input[indexes]), 0)... };
+	(void)expanded;
 }
 
 } // namespace
@@ -99,7 +137,7 @@ void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index
 template <typename T>
 Serialisable::JSON serialiseJsonObject(const T& instance) {
 	Serialisable::JSON made = Serialisable::JSON::ArrayType();
-	SerialisableAnyUtils::serialiseMembers<T, 0>(&instance, made,
+	SerialisableAnyUtils::serialiseMembers(&instance, made,
 			std::make_index_sequence<SerialisableAnyUtils::MemberCounter<T, T*>::get()>());
 	return made;
 }
@@ -112,7 +150,7 @@ std::string writeJsonObject(const T& instance) {
 template <typename T>
 T deserialiseJsonObject(const Serialisable::JSON& input) {
 	T made;
-	SerialisableAnyUtils::deserialiseMembers<T, 0>(&made, input,
+	SerialisableAnyUtils::deserialiseMembers(&made, input,
 			std::make_index_sequence<SerialisableAnyUtils::MemberCounter<T, T*>::get()>());
 	return made;
 }
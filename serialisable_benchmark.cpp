@@ -0,0 +1,204 @@
+#include <iostream>
+#include <chrono>
+#include <new>
+#include <cstdlib>
+#include "serialisable.hpp"
+#include "condensed_json.hpp"
+
+// Every allocation is counted, to see how much the containers reallocate
+// All forms of new and delete are replaced, so that everything allocated by malloc() is released by free()
+static size_t allocations = 0;
+
+static void* countedAllocation(size_t size) {
+	allocations++;
+	void* allocated = malloc(size ? size : 1);
+	if (!allocated)
+		throw std::bad_alloc();
+	return allocated;
+}
+
+void* operator new(size_t size) {
+	return countedAllocation(size);
+}
+void* operator new[](size_t size) {
+	return countedAllocation(size);
+}
+void operator delete(void* freed) noexcept {
+	free(freed);
+}
+void operator delete[](void* freed) noexcept {
+	free(freed);
+}
+void operator delete(void* freed, size_t) noexcept {
+	free(freed);
+}
+void operator delete[](void* freed, size_t) noexcept {
+	free(freed);
+}
+
+#ifdef __cpp_aligned_new
+static void* countedAllocation(size_t size, std::align_val_t alignment) {
+	allocations++;
+	size_t aligned = size_t(alignment);
+	void* allocated = aligned_alloc(aligned, (size + aligned - 1) / aligned * aligned); // The size must be a multiple of the alignment
+	if (!allocated)
+		throw std::bad_alloc();
+	return allocated;
+}
+
+void* operator new(size_t size, std::align_val_t alignment) {
+	return countedAllocation(size, alignment);
+}
+void* operator new[](size_t size, std::align_val_t alignment) {
+	return countedAllocation(size, alignment);
+}
+void operator delete(void* freed, std::align_val_t) noexcept {
+	free(freed);
+}
+void operator delete[](void* freed, std::align_val_t) noexcept {
+	free(freed);
+}
+void operator delete(void* freed, size_t, std::align_val_t) noexcept {
+	free(freed);
+}
+void operator delete[](void* freed, size_t, std::align_val_t) noexcept {
+	free(freed);
+}
+#endif
+
+struct Chapter : public Serialisable {
+	std::string contents = "Lorem ipsum dolor sit amet";
+	std::string author = "Anonymous";
+	int pages = 13;
+	double rating = 4.5;
+	bool published = true;
+	std::unordered_map<std::string, std::string> critique;
+
+	virtual void serialisation() {
+		synch("contents", contents);
+		synch("author", author);
+		synch("pages", pages);
+		synch("rating", rating);
+		synch("published", published);
+		synch("critique", critique);
+	}
+};
+
+struct Book : public Serialisable {
+	std::vector<Chapter> chapters;
+
+	virtual void serialisation() {
+		synch("chapters", chapters);
+	}
+};
+
+// Reports the best of a few runs and allocations done by the first one
+template <typename Function>
+void measure(const std::string& name, Function function) {
+	constexpr int RUNS = 5;
+	size_t allocationsBefore = allocations;
+	size_t firstRunAllocations = 0;
+	std::chrono::microseconds best = std::chrono::microseconds::max();
+	for (int i = 0; i < RUNS; i++) {
+		auto start = std::chrono::steady_clock::now();
+		function();
+		best = std::min(best, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start));
+		if (i == 0)
+			firstRunAllocations = allocations - allocationsBefore;
+	}
+	std::cout << name << ": " << best.count() << " us, " << firstRunAllocations << " allocations" << std::endl;
+}
+
+int main() {
+	Book book;
+	book.chapters.resize(10000);
+	for (unsigned int i = 0; i < book.chapters.size(); i++) {
+		book.chapters[i].pages = i;
+		book.chapters[i].critique["Chapter " + std::to_string(i)] = "It's too short";
+		book.chapters[i].critique["Whole book"] = "Some of the chapters are too long";
+	}
+
+	Serialisable::JSON json;
+	std::string text;
+	std::vector<uint8_t> condensed;
+	measure("toJSON", [&] () {
+		json = book.toJSON();
+	});
+	measure("JSONformat::serialise", [&] () {
+		text = json.toString();
+	});
+	measure("JSONformat::deserialise", [&] () {
+		json = Serialisable::JSON::fromString(text);
+	});
+	measure("fromJSON", [&] () {
+		book.fromJSON(json);
+	});
+	measure("CondensedJSON::serialise", [&] () {
+		condensed = json.to<CondensedJSON>();
+	});
+	measure("CondensedJSON::deserialise", [&] () {
+		json = Serialisable::JSON::from<CondensedJSON>(condensed);
+	});
+	measure("JSON node churn", [] () {
+		for (int i = 0; i < 100000; i++) {
+			Serialisable::JSON made;
+			made.setObject()["list"].setArray().push_back("Some long string value");
+		}
+	});
+
+	measure("saveAs<JSONformat>", [&] () {
+		json.saveAs<SerialisableInternals::JSONformat>("benchmark.json");
+	});
+	measure("saveAs<CondensedJSON>", [&] () {
+		json.saveAs<CondensedJSON>("benchmark.cjson");
+	});
+	measure("loadAs<JSONformat>", [&] () {
+		json = Serialisable::JSON::loadAs<SerialisableInternals::JSONformat>("benchmark.json");
+	});
+	measure("loadAs<CondensedJSON>", [&] () {
+		json = Serialisable::JSON::loadAs<CondensedJSON>("benchmark.cjson");
+	});
+	remove("benchmark.json");
+	remove("benchmark.cjson");
+
+	// A message loop encoding into the same buffers, only the first message should need to allocate anything
+	Serialisable::JSON message = book.chapters[1].toJSON();
+	std::string messageText;
+	std::vector<uint8_t> messageCondensed;
+	messageText.clear();
+	message.to<SerialisableInternals::JSONformat>(messageText);
+	messageCondensed.clear();
+	message.to<CondensedJSON>(messageCondensed);
+	measure("JSONformat::serialiseInto reused buffer, 100000 messages", [&] () {
+		for (int i = 0; i < 100000; i++) {
+			messageText.clear();
+			message.to<SerialisableInternals::JSONformat>(messageText);
+		}
+	});
+	measure("CondensedJSON::serialiseInto reused buffer, 100000 messages", [&] () {
+		for (int i = 0; i < 100000; i++) {
+			messageCondensed.clear();
+			message.to<CondensedJSON>(messageCondensed);
+		}
+	});
+	json.to<CondensedJSON>(messageCondensed);
+	measure("CondensedJSON::serialiseInto reused buffer, whole book", [&] () {
+		messageCondensed.clear();
+		json.to<CondensedJSON>(messageCondensed);
+	});
+
+	// The chapters repeat the same long strings, so interning should save most of their memory
+	std::cout << "String memory without interning: " << json.memoryUsage().strings << " bytes" << std::endl;
+	measure("CondensedJSON::deserialise interned", [&] () {
+		SerialisableInternals::StringInterner interner;
+		json = Serialisable::JSON::from<CondensedJSON>(condensed);
+	});
+	{
+		SerialisableInternals::StringInterner interner;
+		json = Serialisable::JSON::fromString(text);
+		auto statistics = interner.statistics();
+		std::cout << "String memory with interning: " << json.memoryUsage().strings << " bytes, " << statistics.strings
+				<< " distinct, " << statistics.hits << " hits, " << statistics.bytesSaved << " bytes saved" << std::endl;
+	}
+	return 0;
+}
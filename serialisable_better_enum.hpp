@@ -16,19 +16,64 @@ struct Serialiser<Serialised, std::enable_if_t<std::is_same<decltype(std::declva
 	* \brief Saves a better enum value into a JSON string
 	* \param The better enum
 	* \return The constructed JSON string
-	* if the value is single precision, the precision of condensed JSON will be guessed
+	* \note If SERIALISABLE_BY_DUGI_BINARY_ENUMS_AS_INTEGERS is defined, binary formats get the integer instead
 	*/
 	static Serialisable::JSON serialise(Serialised value) {
+#ifdef SERIALISABLE_BY_DUGI_BINARY_ENUMS_AS_INTEGERS
+		if (BinaryTarget::active())
+			return Serialisable::JSON(value._to_integral());
+#endif
 		return value._to_string();
 	}
 	/*!
-	* \brief Loads a JSON string into a better enum
+	* \brief Loads a JSON string or integer into a better enum
 	* \param Reference to the result value
 	* \param The JSON string
-	* \throw If the something's wrong with the JSON
+	* \throw If the something's wrong with the JSON, including integers that aren't values of the enum
+	* \note Names are found through a perfect hash table without allocating
 	*/
 	static void deserialise(Serialised& result, const Serialisable::JSON& value) {
-		result = Serialised::_from_string(value.string().c_str());
+		const Table& table = names();
+		if (value.type() == Serialisable::JSON::Type::NUMBER) {
+			double number = value.number(); // Compared without converting it, it may not fit
+			for (Integral known : table.values)
+				if (double(known) == number) {
+					result = Serialised::_from_integral_unchecked(known);
+					return;
+				}
+			throw Serialisable::SerialisationError("Unknown value of enum " + std::string(Serialised::_name()) + ": " + std::to_string(number));
+		}
+		int index = table.hash.find(value);
+		if (index < 0)
+			throw Serialisable::SerialisationError("Unknown value of enum " + std::string(Serialised::_name()) + ": " + value.string());
+		result = Serialised::_from_integral_unchecked(table.values[size_t(index)]);
+	}
+
+private:
+	using Integral = decltype(std::declval<Serialised>()._to_integral());
+	constexpr static size_t SIZE = Serialised::_size_constant;
+
+	// Names are not available at compile time in all modes of Better Enums, so the table is built on first use
+	struct Table {
+		NameHash<SIZE> hash;
+		std::array<Integral, SIZE> values;
+
+		Table(const std::array<const char*, SIZE>& names, const std::array<Integral, SIZE>& values) : hash(names), values(values) { }
+	};
+
+	static const Table& names() {
+		static const Table table = [] {
+			std::array<const char*, SIZE> names = {};
+			std::array<Integral, SIZE> values = {};
+			size_t index = 0;
+			for (const char* name : Serialised::_names())
+				names[index++] = name;
+			index = 0;
+			for (Serialised value : Serialised::_values())
+				values[index++] = value._to_integral();
+			return Table(names, values);
+		}();
+		return table;
 	}
 };
 
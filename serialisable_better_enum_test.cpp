@@ -0,0 +1,113 @@
+// Build it with and without SERIALISABLE_BY_DUGI_BINARY_ENUMS_AS_INTEGERS defined, it checks the behaviour of the mode it's built in
+#include <iostream>
+#include "serialisable_better_enum.hpp"
+#include "condensed_json.hpp"
+
+BETTER_ENUM(Channel, int, Red, Green, Blue, Alpha, Luminance, Depth, Stencil)
+
+struct Layer : public Serialisable {
+	Channel channel = Channel::Red;
+	Channel mask = Channel::Alpha;
+	SuperEnum kind = SuperEnum::AAAA;
+
+	virtual void serialisation() {
+		synch("channel", channel);
+		synch("mask", mask);
+		synch("kind", kind);
+	}
+};
+
+int main() {
+	bool correct = true;
+	Layer layer;
+	layer.channel = Channel::Stencil;
+	layer.mask = Channel::Green;
+	layer.kind = SuperEnum::BBBB;
+
+	// Text formats always use the names
+	Serialisable::JSON saved = layer.toJSON();
+	if (saved["channel"].type() != Serialisable::JSON::Type::STRING || saved["channel"].string() != "Stencil"
+			|| saved["kind"].string() != "BBBB") {
+		std::cout << "Better enums were not saved as names" << std::endl;
+		correct = false;
+	}
+	Layer reloaded;
+	reloaded.fromJSON(Serialisable::JSON::from<SerialisableInternals::JSONformat>(layer.to<SerialisableInternals::JSONformat>()));
+	if (reloaded.channel != +Channel::Stencil || reloaded.mask != +Channel::Green || reloaded.kind != +SuperEnum::BBBB) {
+		std::cout << "Better enums were not reloaded from names" << std::endl;
+		correct = false;
+	}
+
+	// Binary formats use integers only in the mode that enables it, loading accepts both
+	{
+		SerialisableInternals::BinaryTarget::Scope target(true);
+		Serialisable::JSON binary = layer.toJSON();
+#ifdef SERIALISABLE_BY_DUGI_BINARY_ENUMS_AS_INTEGERS
+		bool expected = binary["channel"].type() == Serialisable::JSON::Type::NUMBER && binary["channel"].number() == Channel(Channel::Stencil)._to_integral();
+#else
+		bool expected = binary["channel"].type() == Serialisable::JSON::Type::STRING;
+#endif
+		if (!expected) {
+			std::cout << "Better enums were saved into binary formats in the wrong form" << std::endl;
+			correct = false;
+		}
+	}
+	Layer fromBinary;
+	fromBinary.fromJSON(Serialisable::JSON::from<CondensedJSON>(layer.to<CondensedJSON>()));
+	if (fromBinary.channel != +Channel::Stencil || fromBinary.mask != +Channel::Green || fromBinary.kind != +SuperEnum::BBBB) {
+		std::cout << "Better enums were not reloaded from a binary format" << std::endl;
+		correct = false;
+	}
+
+	// Names that aren't in the enum, including prefixes and longer names, are rejected
+	for (const char* invalid : { "Purple", "Re", "Redd", "", "red" }) {
+		Serialisable::JSON wrong = layer.toJSON();
+		wrong["channel"] = Serialisable::JSON(invalid);
+		try {
+			Layer rejected;
+			rejected.fromJSON(wrong);
+			std::cout << "Unknown better enum name '" << invalid << "' was accepted" << std::endl;
+			correct = false;
+		} catch (Serialisable::SerialisationError&) { }
+	}
+
+	// Integers are accepted only if they are values of the enum
+	{
+		Serialisable::JSON numbered = layer.toJSON();
+		numbered["channel"] = Serialisable::JSON(Channel(Channel::Alpha)._to_integral());
+		Layer fromNumber;
+		fromNumber.fromJSON(numbered);
+		if (fromNumber.channel != +Channel::Alpha) {
+			std::cout << "Better enum was not loaded from an integer" << std::endl;
+			correct = false;
+		}
+		for (double invalid : { 7.0, -1.0, 2.5, 1e30 }) {
+			numbered["channel"] = Serialisable::JSON(invalid);
+			try {
+				Layer rejected;
+				rejected.fromJSON(numbered);
+				std::cout << "Better enum value " << invalid << " that isn't in the enum was accepted" << std::endl;
+				correct = false;
+			} catch (Serialisable::SerialisationError&) { }
+		}
+	}
+
+	// Every name is found at its index
+	{
+		std::array<const char*, 7> names = {{ "Red", "Green", "Blue", "Alpha", "Luminance", "Depth", "Stencil" }};
+		SerialisableInternals::NameHash<7> hash(names);
+		for (int i = 0; i < int(names.size()); i++)
+			if (hash.find(names[i], strlen(names[i])) != i) {
+				std::cout << "Name " << names[i] << " was not found at its index" << std::endl;
+				correct = false;
+			}
+		if (hash.find("Green ", 6) != -1 || hash.find("Gre", 3) != -1) {
+			std::cout << "A name that was not added was found" << std::endl;
+			correct = false;
+		}
+	}
+
+	if (correct)
+		std::cout << "Better enums work correctly" << std::endl;
+	return correct ? 0 : 1;
+}
@@ -144,6 +144,7 @@ protected:
 	SerialisableBrief(Args... args) {
 		if (uint8_t(serialisationInfo().state) < uint8_t(InitialisationState::INITIALISED)) {
 			if (serialisationInfo().state == InitialisationState::UNINITIALISED) {
+				SERIALISABLE_BY_DUGI_TRACE_SPAN("layout", SerialisableInternals::Tracing::typeName(typeid(Child)) + " layout discovery");
 				// Prepare stuff
 				serialisationInfo().state = InitialisationState::INITIALISING;
 				SerialisationSetupData info;
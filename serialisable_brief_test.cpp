@@ -6,6 +6,15 @@ enum DocumentType {
 	ESSAY
 };
 
+namespace SerialisableInternals {
+template <>
+struct EnumNames<DocumentType> {
+	constexpr static std::array<EnumName<DocumentType>, 2> names() {
+		return {{ { BOOK, "book" }, { ESSAY, "essay" } }};
+	}
+};
+}
+
 struct Chapter : public SerialisableBrief<Chapter> {
 	std::string contents = key("contents");
 	std::string author = key("author") = "Anonymous";
@@ -36,5 +45,11 @@ int main() {
 	prefs.documentType = ESSAY;
 	prefs.save("prefs.json");
 
+	Preferences reloaded;
+	reloaded.load("prefs.json");
+	if (reloaded.documentType != ESSAY || reloaded.footnotes.size() != prefs.footnotes.size()) {
+		std::cout << "The preferences were not reloaded correctly" << std::endl;
+		return 1;
+	}
 	return 0;
 }
@@ -0,0 +1,272 @@
+#ifndef SERIALISABLE_FORK_HPP
+#define SERIALISABLE_FORK_HPP
+#include "serialisable.hpp"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+/*!
+* \brief Saves an object to a file from a child process, the caller only waits for fork() and can modify the object meanwhile
+*
+* \note The child sees the memory as it was at the moment of forking, pages modified by the parent later are copied by the system,
+* so memory usage can grow by the size of the modified state, plus the child's serialised copy
+* \note The file is written under a temporary name, checking every write, and renamed once it's complete and synchronised,
+* so a failed or interrupted snapshot leaves the previous file intact
+* \note Only the calling thread exists in the child, the child can deadlock if another thread held a lock the serialisation needs
+* at the moment of forking (the system's allocator and the JSON node allocator are safe)
+* \note Requires a POSIX system
+*/
+class ForkedSnapshot {
+	pid_t _child = -1;
+	int _descriptor = -1; // Read end of a pipe the child writes the error into, it's closed when the child exits
+	std::chrono::nanoseconds _pause = {};
+	std::string _failure;
+
+	static void writeAll(int descriptor, const char* data, size_t size) {
+		while (size > 0) {
+			ssize_t written = ::write(descriptor, data, size);
+			if (written < 0 && errno == EINTR)
+				continue;
+			if (written <= 0)
+				return;
+			data += written;
+			size -= written;
+		}
+	}
+
+	template <typename Function>
+	explicit ForkedSnapshot(Function save) {
+		int ends[2];
+		if (::pipe(ends) != 0)
+			throw std::runtime_error(std::string("Could not create a pipe for a snapshot: ") + strerror(errno));
+		auto start = std::chrono::steady_clock::now();
+		SerialisableInternals::NodeAllocator::lockForFork();
+		pid_t child = ::fork();
+		SerialisableInternals::NodeAllocator::unlockAfterFork();
+		if (child == 0) {
+			::close(ends[0]);
+			int status = 0;
+			try {
+				save();
+			} catch (std::exception& error) {
+				writeAll(ends[1], error.what(), strlen(error.what()));
+				status = 1;
+			} catch (...) {
+				const char* message = "Unknown exception";
+				writeAll(ends[1], message, strlen(message));
+				status = 1;
+			}
+			::_exit(status); // The parent's static objects and buffered streams must not be destroyed or flushed here
+		}
+		_pause = std::chrono::steady_clock::now() - start;
+		::close(ends[1]);
+		if (child < 0) {
+			int error = errno;
+			::close(ends[0]);
+			throw std::runtime_error(std::string("Could not fork to save a snapshot: ") + strerror(error));
+		}
+		_child = child;
+		_descriptor = ends[0];
+		::fcntl(_descriptor, F_SETFD, FD_CLOEXEC);
+		::fcntl(_descriptor, F_SETFL, O_NONBLOCK); // Other children may hold its write end, so it may never be closed
+	}
+
+	// Writes into a file through a buffer, checking every write
+	class FileSink {
+		constexpr static size_t BUFFER_SIZE = 1 << 16;
+		std::string _fileName;
+		int _descriptor;
+		std::vector<char> _buffer;
+
+		void writeChecked(const char* data, size_t size) {
+			while (size > 0) {
+				ssize_t written = ::write(_descriptor, data, size);
+				if (written < 0 && errno == EINTR)
+					continue;
+				if (written < 0)
+					throw std::runtime_error("Could not write " + _fileName + ": " + strerror(errno));
+				if (written == 0)
+					throw std::runtime_error("Could not write " + _fileName);
+				data += written;
+				size -= written;
+			}
+		}
+		void flush() {
+			writeChecked(_buffer.data(), _buffer.size());
+			_buffer.clear();
+		}
+
+	public:
+		FileSink(const std::string& fileName) : _fileName(fileName),
+				_descriptor(::open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) {
+			if (_descriptor < 0)
+				throw std::runtime_error("Could not open " + fileName + ": " + strerror(errno));
+			_buffer.reserve(BUFFER_SIZE);
+		}
+		FileSink(const FileSink&) = delete;
+		// Deletes the file if it wasn't finished
+		~FileSink() {
+			if (_descriptor >= 0) {
+				::close(_descriptor);
+				::unlink(_fileName.c_str());
+			}
+		}
+
+		void push_back(char value) {
+			_buffer.push_back(value);
+			if (_buffer.size() == BUFFER_SIZE)
+				flush();
+		}
+		void write(const char* data, size_t size) {
+			flush();
+			writeChecked(data, size);
+		}
+
+		// Writes the rest, waits until it's on the disk and closes it
+		void finish() {
+			flush();
+			if (::fsync(_descriptor) != 0)
+				throw std::runtime_error("Could not synchronise " + _fileName + ": " + strerror(errno));
+			int closed = ::close(_descriptor);
+			_descriptor = -1;
+			if (closed != 0) {
+				int error = errno;
+				::unlink(_fileName.c_str());
+				throw std::runtime_error("Could not close " + _fileName + ": " + strerror(error));
+			}
+		}
+	};
+
+	template <typename Format>
+	static void encode(const ISerialisable& source, FileSink& sink, std::true_type) {
+		source.to<Format>(sink);
+	}
+	template <typename Format>
+	static void encode(const ISerialisable& source, FileSink& sink, std::false_type) {
+		auto serialised = source.to<Format>();
+		sink.write(reinterpret_cast<const char*>(serialised.data()), serialised.size() * sizeof(*serialised.data()));
+	}
+
+	template <typename Format>
+	static void saveInChild(const ISerialisable& source, const std::string& fileName) {
+		std::string temporary = fileName + ".snapshot";
+		{
+			FileSink sink(temporary);
+			encode<Format>(source, sink, SerialisableInternals::WritesIntoSink<Format, FileSink>());
+			sink.finish();
+		}
+		if (::rename(temporary.c_str(), fileName.c_str()) != 0) {
+			int error = errno;
+			::unlink(temporary.c_str());
+			throw std::runtime_error("Could not rename " + temporary + " to " + fileName + ": " + strerror(error));
+		}
+	}
+
+	// Returns false if the child is still running and it's not supposed to wait
+	bool collect(bool block) {
+		if (_child < 0)
+			return true;
+		int status = 0;
+		pid_t finished = 0;
+		do {
+			finished = ::waitpid(_child, &status, block ? 0 : WNOHANG);
+		} while (finished < 0 && errno == EINTR);
+		if (finished == 0)
+			return false;
+		int waitError = errno;
+		_child = -1;
+
+		std::string message;
+		char buffer[256];
+		ssize_t read = 0;
+		while ((read = ::read(_descriptor, buffer, sizeof(buffer))) > 0)
+			message.append(buffer, read);
+		::close(_descriptor);
+		_descriptor = -1;
+
+		if (finished < 0)
+			_failure = std::string("Could not wait for the snapshot's process: ") + strerror(waitError);
+		else if (WIFSIGNALED(status))
+			_failure = "The snapshot's process was killed by signal " + std::to_string(WTERMSIG(status));
+		else if (WEXITSTATUS(status) != 0)
+			_failure = message.empty() ? "The snapshot's process failed with code " + std::to_string(WEXITSTATUS(status)) : message;
+		return true;
+	}
+
+	void checkFailure() const {
+		if (!_failure.empty())
+			throw std::runtime_error("Snapshot failed: " + _failure);
+	}
+
+public:
+	/*!
+	* \brief Starts saving the object to a custom format file in a child process
+	* \tparam The format
+	* \param The object
+	* \param The name of the file, it's replaced only when the new one is complete
+	* \return The snapshot, to check if it's finished
+	* \throw If the process cannot be created
+	*
+	* \note It calls the overloaded serialisation() method in the child process
+	*/
+	template <typename Format>
+	static ForkedSnapshot saveAs(const ISerialisable& source, const std::string& fileName) {
+		return ForkedSnapshot([&] () { saveInChild<Format>(source, fileName); });
+	}
+
+	/*!
+	* \brief Starts saving the object to a JSON file in a child process
+	* \param The object
+	* \param The name of the file, it's replaced only when the new one is complete
+	* \return The snapshot, to check if it's finished
+	* \throw If the process cannot be created
+	*/
+	static ForkedSnapshot save(const ISerialisable& source, const std::string& fileName) {
+		return saveAs<SerialisableInternals::JSONformat>(source, fileName);
+	}
+
+	ForkedSnapshot(ForkedSnapshot&& other) noexcept
+			: _child(other._child), _descriptor(other._descriptor), _pause(other._pause), _failure(std::move(other._failure)) {
+		other._child = -1;
+		other._descriptor = -1;
+	}
+	ForkedSnapshot(const ForkedSnapshot&) = delete;
+	ForkedSnapshot& operator=(const ForkedSnapshot&) = delete;
+
+	// Waits for the child process if it's still running, errors are ignored
+	~ForkedSnapshot() {
+		collect(true);
+	}
+
+	/*!
+	* \brief Checks if the child process has finished, without waiting
+	* \return True if the file is saved
+	* \throw If the child process failed
+	*/
+	bool finished() {
+		bool done = collect(false);
+		checkFailure();
+		return done;
+	}
+
+	/*!
+	* \brief Waits until the child process finishes
+	* \throw If the child process failed
+	*/
+	void wait() {
+		collect(true);
+		checkFailure();
+	}
+
+	// A descriptor that becomes readable when the child process ends (unless another child keeps it open), for poll() in an event loop, -1 if it was collected
+	int descriptor() const {
+		return _descriptor;
+	}
+
+	// How long the calling thread was paused to create the child process
+	std::chrono::nanoseconds pauseTime() const {
+		return _pause;
+	}
+};
+
+#endif // SERIALISABLE_FORK_HPP
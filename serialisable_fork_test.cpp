@@ -0,0 +1,151 @@
+#include <iostream>
+#include "serialisable_fork.hpp"
+#include "condensed_json.hpp"
+#include <csignal>
+#include <sys/resource.h>
+
+struct Record : public Serialisable {
+	int id = 0;
+	std::string name;
+	std::vector<double> values;
+
+	virtual void serialisation() {
+		synch("id", id);
+		synch("name", name);
+		synch("values", values);
+	}
+};
+
+struct State : public Serialisable {
+	int64_t generation = 0;
+	std::vector<Record> records;
+
+	virtual void serialisation() {
+		synch("generation", generation);
+		synch("records", records);
+	}
+};
+
+static void makeState(State& state, int records) {
+	state.records.resize(records);
+	for (int i = 0; i < records; i++) {
+		state.records[i].id = i;
+		state.records[i].name = "Record number " + std::to_string(i);
+		state.records[i].values.resize(32, i);
+	}
+}
+
+static size_t residentMegabytes() {
+	std::ifstream file("/proc/self/statm");
+	size_t total = 0;
+	size_t resident = 0;
+	file >> total >> resident;
+	return resident * size_t(sysconf(_SC_PAGESIZE)) >> 20;
+}
+
+template <typename Function>
+static long long measure(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	bool correct = true;
+	const std::string fileName = "fork_test.cjson";
+	remove(fileName.c_str());
+
+	// The pause of saving in the process grows with the serialisation, the pause of forking grows only with the memory to map
+	for (int records : { 10000, 100000, 400000 }) {
+		State state;
+		makeState(state, records);
+		long long inProcess = measure([&] () { state.saveAs<CondensedJSON>(fileName); });
+		ForkedSnapshot snapshot = ForkedSnapshot::saveAs<CondensedJSON>(state, fileName);
+		long long pause = std::chrono::duration_cast<std::chrono::microseconds>(snapshot.pauseTime()).count();
+		long long waited = measure([&] () { snapshot.wait(); });
+		std::cout << records << " records, " << residentMegabytes() << " MiB resident: saving pauses for " << inProcess
+				<< " us, forking pauses for " << pause << " us, the child took " << waited << " us more" << std::endl;
+	}
+
+	// The snapshot must contain the state at the moment of forking, even if it's modified right afterwards
+	{
+		State state;
+		makeState(state, 50000);
+		state.generation = 1;
+		ForkedSnapshot snapshot = ForkedSnapshot::saveAs<CondensedJSON>(state, fileName);
+		state.generation = 2;
+		for (auto& it : state.records)
+			it.values.assign(5, -1);
+		state.records.resize(10);
+		int polls = 0;
+		while (!snapshot.finished()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			polls++;
+		}
+		State read;
+		read.loadAs<CondensedJSON>(fileName);
+		State expected;
+		makeState(expected, 50000);
+		bool same = read.generation == 1 && read.records.size() == expected.records.size();
+		for (size_t i = 0; same && i < read.records.size(); i++)
+			same = read.records[i].id == expected.records[i].id && read.records[i].name == expected.records[i].name
+					&& read.records[i].values == expected.records[i].values;
+		if (!same) {
+			std::cout << "The snapshot doesn't contain the state at the moment of forking" << std::endl;
+			correct = false;
+		}
+		std::cout << "Polled " << polls << " times while the child was saving" << std::endl;
+	}
+
+	// A failure in the child is reported and the previous file is kept
+	{
+		State state;
+		makeState(state, 10);
+		ForkedSnapshot snapshot = ForkedSnapshot::saveAs<CondensedJSON>(state, "/nonexistent/directory/fork_test.cjson");
+		try {
+			snapshot.wait();
+			std::cout << "The failure was not reported" << std::endl;
+			correct = false;
+		} catch (std::runtime_error& error) {
+			std::cout << "Failure reported: " << error.what() << std::endl;
+		}
+		State read;
+		read.loadAs<CondensedJSON>(fileName);
+		if (read.generation != 1) {
+			std::cout << "The previous snapshot was damaged" << std::endl;
+			correct = false;
+		}
+	}
+	// Writing fails in the middle (the file size limit is inherited by the child), the previous file must stay intact
+	{
+		State state;
+		makeState(state, 100000);
+		state.generation = 3;
+		signal(SIGXFSZ, SIG_IGN);
+		rlimit previous;
+		getrlimit(RLIMIT_FSIZE, &previous);
+		rlimit limited = previous;
+		limited.rlim_cur = 1 << 20;
+		setrlimit(RLIMIT_FSIZE, &limited);
+		ForkedSnapshot snapshot = ForkedSnapshot::saveAs<CondensedJSON>(state, fileName);
+		setrlimit(RLIMIT_FSIZE, &previous);
+		try {
+			snapshot.wait();
+			std::cout << "The failed write was not reported" << std::endl;
+			correct = false;
+		} catch (std::runtime_error& error) {
+			std::cout << "Failure reported: " << error.what() << std::endl;
+		}
+		State read;
+		read.loadAs<CondensedJSON>(fileName);
+		if (read.generation != 1 || read.records.size() != 50000 || std::ifstream(fileName + ".snapshot").is_open()) {
+			std::cout << "The previous snapshot was damaged by a failed write" << std::endl;
+			correct = false;
+		}
+	}
+	remove(fileName.c_str());
+
+	if (correct)
+		std::cout << "Forked snapshots work correctly" << std::endl;
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+#ifndef SERIALISABLE_FRAMING_HPP
+#define SERIALISABLE_FRAMING_HPP
+#include "serialisable.hpp"
+#include <cerrno>
+#include <climits>
+#include <sys/uio.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace SerialisableInternals {
+
+// Output buffer made of fixed size chunks, so growing it never moves what was already written
+class ChunkedBuffer {
+	constexpr static size_t CHUNK_SIZE = 4096;
+	std::vector<std::unique_ptr<uint8_t[]>> _chunks;
+	size_t _used = 0;
+	size_t _position = CHUNK_SIZE; // In the last used chunk
+	size_t _size = 0;
+public:
+	void push_back(uint8_t value) {
+		if (_position == CHUNK_SIZE) {
+			if (_used == _chunks.size())
+				_chunks.emplace_back(new uint8_t[CHUNK_SIZE]);
+			_used++;
+			_position = 0;
+		}
+		_chunks[_used - 1][_position++] = value;
+		_size++;
+	}
+
+	// Keeps the chunks allocated for the next use
+	void clear() {
+		_used = 0;
+		_position = CHUNK_SIZE;
+		_size = 0;
+	}
+
+	size_t size() const {
+		return _size;
+	}
+
+	template <typename Function>
+	void forEachChunk(Function function) const {
+		for (size_t i = 0; i < _used; i++)
+			function(_chunks[i].get(), i + 1 < _used ? CHUNK_SIZE : _position);
+	}
+};
+
+// Writes everything even if the descriptor accepts only a part of it at once, the vectors are modified
+inline void writeVectors(int descriptor, iovec* vectors, int count) {
+	while (count > 0) {
+		ssize_t written = writev(descriptor, vectors, std::min(count, IOV_MAX));
+		if (written < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				pollfd waiting = { descriptor, POLLOUT, 0 };
+				poll(&waiting, 1, -1);
+				continue;
+			}
+			throw std::runtime_error(std::string("Could not write: ") + strerror(errno));
+		}
+		while (count > 0 && size_t(written) >= vectors->iov_len) {
+			written -= vectors->iov_len;
+			vectors++;
+			count--;
+		}
+		if (count > 0) {
+			vectors->iov_base = reinterpret_cast<uint8_t*>(vectors->iov_base) + written;
+			vectors->iov_len -= written;
+		}
+	}
+}
+
+} // namespace
+
+/*!
+* \brief Writes serialised objects into a socket or pipe as frames prefixed by their length
+*
+* \note The length is 4 bytes, little endian
+* \note The frame is written with one writev() call from the buffers where it was encoded, without concatenating them
+*/
+class FrameWriter {
+	SerialisableInternals::ChunkedBuffer _buffer;
+	std::vector<iovec> _vectors;
+	uint8_t _header[4];
+
+	void setHeader(size_t size) {
+		if (size > UINT32_MAX)
+			throw Serialisable::SerialisationError("Frame of " + std::to_string(size) + " bytes is too large");
+		for (int i = 0; i < 4; i++)
+			_header[i] = (size >> (i * 8)) & 0xff;
+		_vectors.clear();
+		_vectors.push_back({ _header, sizeof(_header) });
+	}
+
+	template <typename Format>
+	void send(int descriptor, const Serialisable::JSON& source, std::true_type) {
+		_buffer.clear();
+		Format::serialiseInto(source, _buffer);
+		setHeader(_buffer.size());
+		_buffer.forEachChunk([&] (uint8_t* data, size_t size) {
+			_vectors.push_back({ data, size });
+		});
+		SerialisableInternals::writeVectors(descriptor, _vectors.data(), int(_vectors.size()));
+	}
+
+	template <typename Format>
+	void send(int descriptor, const Serialisable::JSON& source, std::false_type) {
+		auto made = Format::serialise(source);
+		setHeader(made.size());
+		_vectors.push_back({ const_cast<void*>(static_cast<const void*>(made.data())), made.size() });
+		SerialisableInternals::writeVectors(descriptor, _vectors.data(), int(_vectors.size()));
+	}
+
+public:
+	/*!
+	* \brief Serialises an object and writes it as a frame
+	* \tparam The format
+	* \param The file descriptor
+	* \param The object
+	* \throw If writing fails
+	*
+	* \note It calls the overloaded serialisation() method
+	* \note If the descriptor is non-blocking, it waits until it can write
+	*/
+	template <typename Format>
+	void send(int descriptor, const ISerialisable& source) {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		send<Format>(descriptor, source.toJSON());
+	}
+
+	/*!
+	* \brief Serialises a JSON and writes it as a frame
+	* \tparam The format, formats with serialiseInto() are encoded into reused chunks, others are written from what serialise() returns
+	* \param The file descriptor
+	* \param The JSON
+	* \throw If writing fails
+	*/
+	template <typename Format>
+	void send(int descriptor, const Serialisable::JSON& source) {
+		send<Format>(descriptor, source, SerialisableInternals::WritesIntoSink<Format, SerialisableInternals::ChunkedBuffer>());
+	}
+};
+
+/*!
+* \brief Reassembles frames written by FrameWriter from a socket or pipe and decodes them
+*
+* \note Frames are decoded from the read buffer, formats with deserialiseBytes() don't copy them at all
+*/
+class FrameReader {
+	constexpr static size_t HEADER_SIZE = 4;
+	constexpr static size_t MIN_READ = 4096;
+	std::vector<uint8_t> _buffer;
+	size_t _start = 0;
+	size_t _end = 0;
+	size_t _maxFrameSize;
+
+	size_t frameSize() const {
+		size_t size = 0;
+		for (size_t i = 0; i < HEADER_SIZE; i++)
+			size |= size_t(_buffer[_start + i]) << (i * 8);
+		if (size > _maxFrameSize)
+			throw Serialisable::SerialisationError("Frame of " + std::to_string(size) + " bytes is larger than allowed");
+		return size;
+	}
+
+public:
+	/*!
+	* \brief Constructs the reader
+	* \param Size of the largest frame accepted, larger ones are considered corrupted data
+	*/
+	FrameReader(size_t maxFrameSize = 1 << 26) : _maxFrameSize(maxFrameSize) { }
+
+	/*!
+	* \brief Reads what's available from a file descriptor into the buffer
+	* \param The file descriptor
+	* \return False if the other side closed it
+	* \throw If reading fails
+	*
+	* \note It blocks if the descriptor is blocking and nothing is available
+	*/
+	bool receive(int descriptor) {
+		size_t pending = _end - _start;
+		size_t wanted = MIN_READ;
+		if (pending >= HEADER_SIZE)
+			wanted = std::max(wanted, HEADER_SIZE + frameSize() - pending);
+		if (_buffer.size() - _end < wanted) {
+			if (_start > 0) { // Only the unfinished frame is moved
+				memmove(_buffer.data(), _buffer.data() + _start, pending);
+				_start = 0;
+				_end = pending;
+			}
+			if (_buffer.size() - _end < wanted)
+				_buffer.resize(_end + wanted);
+		}
+		while (true) {
+			ssize_t got = ::read(descriptor, _buffer.data() + _end, _buffer.size() - _end);
+			if (got > 0) {
+				_end += got;
+				return true;
+			}
+			if (got == 0)
+				return false;
+			if (errno == EAGAIN || errno == EWOULDBLOCK)
+				return true;
+			if (errno != EINTR)
+				throw std::runtime_error(std::string("Could not read a frame: ") + strerror(errno));
+		}
+	}
+
+	/*!
+	* \brief Decodes the next frame if it was received whole
+	* \tparam The format
+	* \param The JSON to overwrite with the frame's contents
+	* \return False if no whole frame is in the buffer
+	* \throw If the frame isn't valid
+	*/
+	template <typename Format>
+	bool next(Serialisable::JSON& result) {
+		if (_end - _start < HEADER_SIZE)
+			return false;
+		size_t size = frameSize();
+		if (_end - _start < HEADER_SIZE + size)
+			return false;
+		const uint8_t* data = _buffer.data() + _start + HEADER_SIZE;
+		_start += HEADER_SIZE + size;
+		if (_start == _end)
+			_start = _end = 0;
+		result = SerialisableInternals::BytesDecoder<Format>::decode(data, size); // Data stay there until the next receive()
+		return true;
+	}
+
+	/*!
+	* \brief Decodes the next frame into an object if it was received whole
+	* \tparam The format
+	* \param The object
+	* \return False if no whole frame is in the buffer
+	* \throw If the frame isn't valid
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	template <typename Format>
+	bool next(ISerialisable& result) {
+		Serialisable::JSON read;
+		if (!next<Format>(read))
+			return false;
+		result.fromJSON(read);
+		return true;
+	}
+
+	/*!
+	* \brief Reads a frame from a blocking file descriptor and decodes it into an object
+	* \tparam The format
+	* \param The file descriptor
+	* \param The object
+	* \return False if the other side closed it before sending another frame
+	* \throw If reading fails, the frame isn't valid or the descriptor was closed in the middle of a frame
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	template <typename Format>
+	bool read(int descriptor, ISerialisable& result) {
+		while (!next<Format>(result)) {
+			if (!receive(descriptor)) {
+				if (_end != _start)
+					throw Serialisable::SerialisationError("Stream ended in the middle of a frame");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Bytes received but not decoded yet
+	size_t buffered() const {
+		return _end - _start;
+	}
+};
+
+#endif // SERIALISABLE_FRAMING_HPP
@@ -0,0 +1,80 @@
+#include <iostream>
+#include <thread>
+#include <sys/socket.h>
+#include "serialisable_framing.hpp"
+#include "condensed_json.hpp"
+
+struct Message : public Serialisable {
+	int64_t sequence = 0;
+	std::string text;
+	std::vector<int> values;
+
+	virtual void serialisation() {
+		synch("sequence", sequence);
+		synch("text", text);
+		synch("values", values);
+	}
+};
+
+// Sizes vary from a few bytes to more than the socket buffer, so that frames are split and joined
+static Message makeMessage(int sequence) {
+	Message made;
+	made.sequence = sequence;
+	made.text = std::string(sequence % 3 == 0 ? sequence * 37 % 200000 : sequence % 50, 'a' + sequence % 26);
+	made.values.resize(sequence % 17, sequence);
+	return made;
+}
+
+template <typename Format>
+static bool exchange(const std::string& name, int messages) {
+	int sockets[2];
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0) {
+		std::cout << "Could not create sockets" << std::endl;
+		return false;
+	}
+	std::thread sender([&] {
+		FrameWriter writer;
+		for (int i = 0; i < messages; i++)
+			writer.send<Format>(sockets[0], makeMessage(i));
+		close(sockets[0]);
+	});
+
+	FrameReader reader;
+	Message received;
+	int count = 0;
+	bool correct = true;
+	while (reader.read<Format>(sockets[1], received)) {
+		Message expected = makeMessage(count);
+		if (received.sequence != expected.sequence || received.text != expected.text || received.values != expected.values)
+			correct = false;
+		count++;
+	}
+	sender.join();
+	close(sockets[1]);
+	if (!correct || count != messages) {
+		std::cout << name << " frames were not received correctly, got " << count << " of " << messages << std::endl;
+		return false;
+	}
+	return true;
+}
+
+int main() {
+	if (!exchange<CondensedJSON>("Condensed", 2000) || !exchange<SerialisableInternals::JSONformat>("JSON", 500))
+		return 1;
+
+	int sockets[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, sockets);
+	const uint8_t truncated[] = { 10, 0, 0, 0, 1, 2 };
+	if (write(sockets[0], truncated, sizeof(truncated)) != sizeof(truncated))
+		return 1;
+	close(sockets[0]);
+	FrameReader reader;
+	Message received;
+	try {
+		reader.read<CondensedJSON>(sockets[1], received);
+		std::cout << "Truncated frame was not noticed" << std::endl;
+		return 1;
+	} catch (Serialisable::SerialisationError&) { }
+	close(sockets[1]);
+	return 0;
+}
@@ -0,0 +1,88 @@
+// Serialises aggregates with many members through SerialisableQuick and SerialisableAny, mainly to measure how long it takes to compile
+// The number of members is set by LARGE_AGGREGATE_MEMBERS (10, 100 or 500), one of the two can be left out to time the other alone:
+// time g++ -std=c++17 -O0 -DLARGE_AGGREGATE_MEMBERS=500 -DLARGE_AGGREGATE_ANY=0 serialisable_large_aggregate_test.cpp
+#include <iostream>
+#include "serialisable_quick.hpp"
+#include "serialisable_any.hpp"
+
+#ifndef LARGE_AGGREGATE_MEMBERS
+#define LARGE_AGGREGATE_MEMBERS 100
+#endif
+#ifndef LARGE_AGGREGATE_QUICK
+#define LARGE_AGGREGATE_QUICK 1
+#endif
+#ifndef LARGE_AGGREGATE_ANY
+#define LARGE_AGGREGATE_ANY 1
+#endif
+
+#define MEMBERS_10(MEMBER, PREFIX) MEMBER(PREFIX##0) MEMBER(PREFIX##1) MEMBER(PREFIX##2) MEMBER(PREFIX##3) MEMBER(PREFIX##4) \
+	MEMBER(PREFIX##5) MEMBER(PREFIX##6) MEMBER(PREFIX##7) MEMBER(PREFIX##8) MEMBER(PREFIX##9)
+#define MEMBERS_100(MEMBER, PREFIX) MEMBERS_10(MEMBER, PREFIX##0) MEMBERS_10(MEMBER, PREFIX##1) MEMBERS_10(MEMBER, PREFIX##2) \
+	MEMBERS_10(MEMBER, PREFIX##3) MEMBERS_10(MEMBER, PREFIX##4) MEMBERS_10(MEMBER, PREFIX##5) MEMBERS_10(MEMBER, PREFIX##6) \
+	MEMBERS_10(MEMBER, PREFIX##7) MEMBERS_10(MEMBER, PREFIX##8) MEMBERS_10(MEMBER, PREFIX##9)
+#define MEMBERS_500(MEMBER, PREFIX) MEMBERS_100(MEMBER, PREFIX##0) MEMBERS_100(MEMBER, PREFIX##1) MEMBERS_100(MEMBER, PREFIX##2) \
+	MEMBERS_100(MEMBER, PREFIX##3) MEMBERS_100(MEMBER, PREFIX##4)
+
+#if LARGE_AGGREGATE_MEMBERS == 10
+#define MEMBERS(MEMBER) MEMBERS_10(MEMBER, m)
+#define FIRST_MEMBER m0
+#define LAST_MEMBER m9
+#elif LARGE_AGGREGATE_MEMBERS == 100
+#define MEMBERS(MEMBER) MEMBERS_100(MEMBER, m)
+#define FIRST_MEMBER m00
+#define LAST_MEMBER m99
+#elif LARGE_AGGREGATE_MEMBERS == 500
+#define MEMBERS(MEMBER) MEMBERS_500(MEMBER, m)
+#define FIRST_MEMBER m000
+#define LAST_MEMBER m499
+#else
+#error "LARGE_AGGREGATE_MEMBERS must be 10, 100 or 500"
+#endif
+
+#define QUICK_MEMBER(NAME) int NAME = key(#NAME) = 0;
+#define ANY_MEMBER(NAME) int NAME = 0;
+
+struct LargeQuick : SerialisableQuick<LargeQuick> {
+	MEMBERS(QUICK_MEMBER)
+};
+
+struct LargeAny {
+	MEMBERS(ANY_MEMBER)
+};
+
+int main() {
+	bool correct = true;
+
+#if LARGE_AGGREGATE_QUICK
+	{
+		LargeQuick saved;
+		saved.FIRST_MEMBER = 1;
+		saved.LAST_MEMBER = 2;
+		Serialisable::JSON json = saved.toJson();
+		LargeQuick loaded;
+		loaded.fromJson(Serialisable::JSON::fromString(json.toString()));
+		if (json.object().size() != LARGE_AGGREGATE_MEMBERS || loaded.FIRST_MEMBER != 1 || loaded.LAST_MEMBER != 2) {
+			std::cout << "An aggregate with " << LARGE_AGGREGATE_MEMBERS << " members was not reloaded by SerialisableQuick" << std::endl;
+			correct = false;
+		}
+	}
+#endif
+
+#if LARGE_AGGREGATE_ANY
+	{
+		LargeAny saved;
+		saved.FIRST_MEMBER = 1;
+		saved.LAST_MEMBER = 2;
+		std::string written = writeJsonObject(saved);
+		LargeAny loaded = readJsonObject<LargeAny>(written);
+		if (Serialisable::JSON::fromString(written).array().size() != LARGE_AGGREGATE_MEMBERS || loaded.FIRST_MEMBER != 1 || loaded.LAST_MEMBER != 2) {
+			std::cout << "An aggregate with " << LARGE_AGGREGATE_MEMBERS << " members was not reloaded by SerialisableAny" << std::endl;
+			correct = false;
+		}
+	}
+#endif
+
+	if (correct)
+		std::cout << "Large aggregates work correctly" << std::endl;
+	return correct ? 0 : 1;
+}
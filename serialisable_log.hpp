@@ -0,0 +1,276 @@
+#ifndef SERIALISABLE_LOG_HPP
+#define SERIALISABLE_LOG_HPP
+#include "serialisable_framing.hpp"
+#include <thread>
+#include <condition_variable>
+#include <fcntl.h>
+
+/*!
+* \brief Writes serialised records from any number of threads into a file, through a background thread
+* \tparam The format, text formats write one record per line (the default is newline-delimited JSON),
+* binary formats prefix each record by its length like FrameWriter, so FrameReader can read them
+*
+* \note Records are serialised in the calling thread into a reused buffer and copied into a ring buffer,
+* the calling thread never waits for a lock or for the disk unless the ring is full
+* \note The background thread writes all finished records with one writev() call
+* \note Records of one thread are written in the order they were logged
+*/
+template <typename Format = SerialisableInternals::CompactJSONformat>
+class SerialisableLog {
+	static_assert(SerialisableInternals::WritesIntoSink<Format, std::vector<uint8_t>>::value, "The format must have serialiseInto()");
+	constexpr static bool FRAMED = SerialisableInternals::IsBinaryFormat<Format>::value;
+	constexpr static size_t LENGTH_SIZE = 4;
+
+	// Each record starts with a state word, the record's size and a flag set once its contents are complete
+	constexpr static uint32_t READY = 1u << 31;
+	constexpr static uint32_t WRAP = 1u << 30; // The rest of the ring is skipped
+	constexpr static uint32_t SIZE_MASK = WRAP - 1;
+	constexpr static size_t RECORD_HEADER = sizeof(uint32_t);
+
+	std::unique_ptr<uint64_t[]> _storage; // For alignment
+	uint8_t* _data;
+	size_t _capacity;
+	alignas(64) std::atomic<uint64_t> _claimed = {0};
+	alignas(64) std::atomic<uint64_t> _released = {0};
+
+	int _descriptor;
+	bool _ownsDescriptor;
+	std::chrono::milliseconds _interval;
+	std::vector<iovec> _vectors;
+	std::exception_ptr _error; // Set only once, before _failed
+	std::atomic<bool> _failed = {false};
+	std::mutex _sleeping;
+	std::condition_variable _wakeUp;
+	std::atomic<bool> _wakeRequested = {false};
+	std::atomic<bool> _stopping = {false};
+	std::thread _writer;
+
+	static std::vector<uint8_t>& localBuffer() {
+		thread_local std::vector<uint8_t> buffer;
+		return buffer;
+	}
+
+	static size_t recordSize(size_t size) {
+		return (RECORD_HEADER + size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+	}
+
+	std::atomic<uint32_t>& state(size_t offset) {
+		return *reinterpret_cast<std::atomic<uint32_t>*>(_data + offset);
+	}
+
+	void wakeWriter() {
+		if (!_wakeRequested.exchange(true, std::memory_order_relaxed)) {
+			std::lock_guard<std::mutex> lock(_sleeping);
+			_wakeUp.notify_one();
+		}
+	}
+
+	// Claims space for a record and copies it there, returns false if it's full and not supposed to wait
+	bool push(const std::vector<uint8_t>& record, bool wait) {
+		const size_t required = recordSize(record.size());
+		if (required > _capacity)
+			throw Serialisable::SerialisationError("Record of " + std::to_string(record.size()) + " bytes doesn't fit into the log's buffer");
+		uint64_t claimed = _claimed.load(std::memory_order_relaxed);
+		size_t offset = 0;
+		size_t skipped = 0;
+		while (true) {
+			offset = claimed & (_capacity - 1);
+			skipped = (_capacity - offset < required) ? _capacity - offset : 0; // Records are never split
+			if (claimed + skipped + required - _released.load(std::memory_order_acquire) > _capacity) {
+				if (!wait)
+					return false;
+				wakeWriter();
+				std::this_thread::yield();
+				claimed = _claimed.load(std::memory_order_relaxed);
+				continue;
+			}
+			if (_claimed.compare_exchange_weak(claimed, claimed + skipped + required, std::memory_order_relaxed))
+				break;
+		}
+		if (skipped) {
+			state(offset).store(READY | WRAP, std::memory_order_release);
+			offset = 0;
+		}
+		memcpy(_data + offset + RECORD_HEADER, record.data(), record.size());
+		state(offset).store(READY | uint32_t(record.size()), std::memory_order_release);
+
+		if (claimed + skipped + required - _released.load(std::memory_order_relaxed) > _capacity / 2)
+			wakeWriter(); // Don't wait for the interval to pass if it's filling up
+		return true;
+	}
+
+	// Zeroes the space of written records, so that a record placed there later doesn't look ready because of the old contents
+	void clear(uint64_t start, uint64_t end) {
+		size_t offset = start & (_capacity - 1);
+		size_t size = end - start;
+		size_t first = std::min(size, _capacity - offset);
+		memset(_data + offset, 0, first);
+		memset(_data, 0, size - first);
+	}
+
+	// Writes the finished records, returns false if there were none
+	bool writeBatch() {
+		uint64_t start = _released.load(std::memory_order_relaxed);
+		uint64_t claimed = _claimed.load(std::memory_order_relaxed);
+		uint64_t position = start;
+		_vectors.clear();
+		while (position < claimed && _vectors.size() < size_t(IOV_MAX)) {
+			size_t offset = position & (_capacity - 1);
+			uint32_t found = state(offset).load(std::memory_order_acquire);
+			if (!(found & READY))
+				break; // Still being written, the following ones will be written with the next batch
+			if (found & WRAP) {
+				position += _capacity - offset;
+				continue;
+			}
+			_vectors.push_back({ _data + offset + RECORD_HEADER, found & SIZE_MASK });
+			position += recordSize(found & SIZE_MASK);
+		}
+		if (position == start)
+			return false;
+
+		if (!_error) {
+			try {
+				SerialisableInternals::writeVectors(_descriptor, _vectors.data(), int(_vectors.size()));
+			} catch (...) {
+				_error = std::current_exception(); // Later records are discarded
+				_failed.store(true, std::memory_order_release);
+			}
+		}
+		clear(start, position);
+		_released.store(position, std::memory_order_release);
+		return true;
+	}
+
+	void run() {
+		while (true) {
+			if (writeBatch())
+				continue;
+			if (_stopping.load() && _released.load() == _claimed.load())
+				return;
+			std::unique_lock<std::mutex> lock(_sleeping);
+			_wakeUp.wait_for(lock, _interval, [this] () { return _wakeRequested.load() || _stopping.load(); });
+			_wakeRequested = false;
+		}
+	}
+
+	bool logRecord(const Serialisable::JSON& source, bool wait) {
+		std::vector<uint8_t>& record = localBuffer();
+		record.clear();
+		if (FRAMED)
+			record.resize(LENGTH_SIZE);
+		source.to<Format>(record);
+		if (FRAMED) {
+			size_t size = record.size() - LENGTH_SIZE;
+			for (size_t i = 0; i < LENGTH_SIZE; i++)
+				record[i] = (size >> (i * 8)) & 0xff;
+		} else
+			record.push_back('\n');
+		return push(record, wait);
+	}
+
+	static size_t roundedCapacity(size_t capacity) {
+		size_t rounded = 64;
+		while (rounded < capacity)
+			rounded <<= 1;
+		if (rounded > SIZE_MASK)
+			throw std::runtime_error("The log's buffer cannot be larger than 1 GiB");
+		return rounded;
+	}
+
+	void start() {
+		_storage = std::make_unique<uint64_t[]>(_capacity / sizeof(uint64_t));
+		_data = reinterpret_cast<uint8_t*>(_storage.get());
+		_writer = std::thread([this] () { run(); });
+	}
+
+public:
+	/*!
+	* \brief Opens a file to append the records to
+	* \param The file name
+	* \param Size of the buffer in bytes, rounded up to a power of two, records that are logged faster than they are written wait if it's full
+	* \param How often the background thread checks for new records if the buffer isn't filling up
+	* \throw If the file cannot be opened
+	*/
+	SerialisableLog(const std::string& fileName, size_t capacity = 1 << 22, std::chrono::milliseconds interval = std::chrono::milliseconds(10))
+			: _capacity(roundedCapacity(capacity)), _descriptor(::open(fileName.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644)), _ownsDescriptor(true), _interval(interval) {
+		if (_descriptor < 0)
+			throw std::runtime_error("Could not open log " + fileName + ": " + strerror(errno));
+		start();
+	}
+
+	/*!
+	* \brief Writes the records into an open file descriptor, it's not closed afterwards
+	* \param The file descriptor
+	* \param Size of the buffer in bytes, rounded up to a power of two
+	* \param How often the background thread checks for new records if the buffer isn't filling up
+	*/
+	SerialisableLog(int descriptor, size_t capacity = 1 << 22, std::chrono::milliseconds interval = std::chrono::milliseconds(10))
+			: _capacity(roundedCapacity(capacity)), _descriptor(descriptor), _ownsDescriptor(false), _interval(interval) {
+		start();
+	}
+
+	SerialisableLog(const SerialisableLog&) = delete;
+	SerialisableLog& operator=(const SerialisableLog&) = delete;
+
+	// Writes all records logged before and stops the background thread
+	~SerialisableLog() {
+		_stopping = true;
+		wakeWriter();
+		_writer.join();
+		if (_ownsDescriptor)
+			::close(_descriptor);
+	}
+
+	/*!
+	* \brief Serialises an object and queues it to be written
+	* \param The object
+	* \throw If the record is larger than the buffer
+	*
+	* \note It calls the overloaded serialisation() method
+	* \note If the buffer is full, it waits until there's space
+	*/
+	void log(const ISerialisable& source) {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		logRecord(source.toJSON(), true);
+	}
+
+	// Serialises a JSON and queues it to be written, waits if the buffer is full
+	void log(const Serialisable::JSON& source) {
+		logRecord(source, true);
+	}
+
+	/*!
+	* \brief Serialises an object and queues it to be written unless the buffer is full
+	* \param The object
+	* \return False if the buffer was full and the record was dropped
+	* \throw If the record is larger than the buffer
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	bool tryLog(const ISerialisable& source) {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		return logRecord(source.toJSON(), false);
+	}
+
+	// Serialises a JSON and queues it to be written unless the buffer is full, returns false if it was dropped
+	bool tryLog(const Serialisable::JSON& source) {
+		return logRecord(source, false);
+	}
+
+	/*!
+	* \brief Waits until all records logged so far are written
+	* \throw If writing into the file failed, records logged after the failure are discarded
+	*/
+	void flush() {
+		uint64_t target = _claimed.load();
+		while (_released.load(std::memory_order_acquire) < target) {
+			wakeWriter();
+			std::this_thread::yield();
+		}
+		if (_failed.load(std::memory_order_acquire))
+			std::rethrow_exception(_error);
+	}
+};
+
+#endif // SERIALISABLE_LOG_HPP
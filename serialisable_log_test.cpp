@@ -0,0 +1,203 @@
+#include <iostream>
+#include <algorithm>
+#include "serialisable_log.hpp"
+#include "condensed_json.hpp"
+
+struct Event : public Serialisable {
+	int thread = 0;
+	int64_t sequence = 0;
+	std::string text;
+	std::vector<int> values;
+
+	virtual void serialisation() {
+		synch("thread", thread);
+		synch("sequence", sequence);
+		synch("text", text);
+		synch("values", values);
+	}
+};
+
+constexpr int THREADS = 4;
+constexpr int EVENTS = 20000;
+
+static Event makeEvent(int thread, int sequence) {
+	Event made;
+	made.thread = thread;
+	made.sequence = sequence;
+	made.text = (sequence % 10 == 0) ? "Line\nbreak" : "Event number " + std::to_string(sequence);
+	made.values.resize(sequence % 7, sequence % 13);
+	return made;
+}
+
+static void printLatencies(const std::string& name, std::vector<std::chrono::nanoseconds>& latencies) {
+	std::sort(latencies.begin(), latencies.end());
+	auto percentile = [&] (double fraction) {
+		return latencies[size_t(fraction * (latencies.size() - 1))].count();
+	};
+	std::cout << name << " latency: median " << percentile(0.5) << " ns, 99% " << percentile(0.99)
+			<< " ns, 99.9% " << percentile(0.999) << " ns" << std::endl;
+}
+
+// Logs from more threads at once and measures how long the calls take
+template <typename Logging>
+static void logFromThreads(const std::string& name, Logging logging) {
+	std::vector<std::vector<std::chrono::nanoseconds>> latencies(THREADS);
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < THREADS; thread++) {
+		threads.emplace_back([&, thread] () {
+			for (int i = 0; i < EVENTS; i++) {
+				Event event = makeEvent(thread, i);
+				Serialisable::JSON json = event.toJSON(); // Not measured, it's the same for all ways of logging
+				auto start = std::chrono::steady_clock::now();
+				logging(json);
+				latencies[thread].push_back(std::chrono::steady_clock::now() - start);
+			}
+		});
+	}
+	for (auto& it : threads)
+		it.join();
+	std::vector<std::chrono::nanoseconds> all;
+	for (auto& it : latencies)
+		all.insert(all.end(), it.begin(), it.end());
+	printLatencies(name, all);
+}
+
+// Every thread's events must be there, in the order they were logged
+static bool checkEvent(const Event& read, std::vector<int>& next) {
+	if (read.thread < 0 || read.thread >= THREADS || read.sequence != next[read.thread])
+		return false;
+	Event expected = makeEvent(read.thread, next[read.thread]++);
+	return read.text == expected.text && read.values == expected.values;
+}
+
+// Records of varying sizes that wrap around a tiny ring many times, the text is not ASCII so payload bytes can have the highest bit set
+static Event makeWrappingEvent(int sequence) {
+	Event made;
+	made.sequence = sequence;
+	made.text = (sequence % 8 < 5) ? "\u00e9t\u00e9 \u00e9\u00e9\u00e9\u00e9\u00e9" : "x";
+	made.values.resize(sequence % 3, 200);
+	return made;
+}
+
+template <typename Format>
+static bool checkWrapping(const std::string& fileName) {
+	constexpr int WRAPPING_EVENTS = 500;
+	remove(fileName.c_str());
+	{
+		SerialisableLog<Format> log(fileName, 256);
+		for (int i = 0; i < WRAPPING_EVENTS; i++)
+			log.log(makeWrappingEvent(i).toJSON());
+	}
+	std::vector<Event> read;
+	if (std::is_same<Format, SerialisableInternals::CompactJSONformat>::value) {
+		std::ifstream file(fileName);
+		std::string line;
+		while (std::getline(file, line)) {
+			read.emplace_back();
+			read.back().fromJSON(Serialisable::JSON::fromString(line));
+		}
+	} else {
+		int descriptor = ::open(fileName.c_str(), O_RDONLY);
+		FrameReader reader;
+		Event event;
+		while (reader.read<Format>(descriptor, event))
+			read.push_back(event);
+		::close(descriptor);
+	}
+	remove(fileName.c_str());
+	if (read.size() != WRAPPING_EVENTS)
+		return false;
+	for (int i = 0; i < WRAPPING_EVENTS; i++) {
+		Event expected = makeWrappingEvent(i);
+		if (read[i].sequence != i || read[i].text != expected.text || read[i].values != expected.values)
+			return false;
+	}
+	return true;
+}
+
+int main() {
+	bool correct = true;
+	const std::string lines = "log_test.ndjson";
+	const std::string frames = "log_test.cjson";
+	remove(lines.c_str());
+	remove(frames.c_str());
+
+	if (!checkWrapping<SerialisableInternals::CompactJSONformat>("log_test_wrapping.ndjson")
+			|| !checkWrapping<CondensedJSON>("log_test_wrapping.cjson")) {
+		std::cout << "Records wrapping around a small buffer were not logged correctly" << std::endl;
+		correct = false;
+	}
+
+	{
+		std::mutex lock;
+		int descriptor = ::open("log_test_mutex.ndjson", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		logFromThreads("Mutex and write()", [&] (const Serialisable::JSON& json) {
+			std::string text = SerialisableInternals::CompactJSONformat::serialise(json) + '\n';
+			std::lock_guard<std::mutex> guard(lock);
+			if (::write(descriptor, text.data(), text.size()) != ssize_t(text.size()))
+				std::cout << "Could not write" << std::endl;
+		});
+		::close(descriptor);
+		remove("log_test_mutex.ndjson");
+	}
+	{
+		SerialisableLog<> log(lines);
+		logFromThreads("SerialisableLog with JSON lines", [&] (const Serialisable::JSON& json) {
+			log.log(json);
+		});
+		log.flush();
+	}
+	{
+		SerialisableLog<CondensedJSON> log(frames);
+		logFromThreads("SerialisableLog with CondensedJSON frames", [&] (const Serialisable::JSON& json) {
+			log.log(json);
+		});
+	}
+
+	{
+		std::ifstream file(lines);
+		std::string line;
+		std::vector<int> next(THREADS, 0);
+		int count = 0;
+		while (std::getline(file, line)) {
+			Event read;
+			read.fromJSON(Serialisable::JSON::fromString(line));
+			if (!checkEvent(read, next)) {
+				std::cout << "Wrong line: " << line << std::endl;
+				correct = false;
+				break;
+			}
+			count++;
+		}
+		if (count != THREADS * EVENTS) {
+			std::cout << "Read " << count << " lines instead of " << THREADS * EVENTS << std::endl;
+			correct = false;
+		}
+	}
+	{
+		int descriptor = ::open(frames.c_str(), O_RDONLY);
+		FrameReader reader;
+		Event read;
+		std::vector<int> next(THREADS, 0);
+		int count = 0;
+		while (reader.read<CondensedJSON>(descriptor, read)) {
+			if (!checkEvent(read, next)) {
+				std::cout << "Wrong frame " << count << std::endl;
+				correct = false;
+				break;
+			}
+			count++;
+		}
+		::close(descriptor);
+		if (count != THREADS * EVENTS) {
+			std::cout << "Read " << count << " frames instead of " << THREADS * EVENTS << std::endl;
+			correct = false;
+		}
+	}
+	remove(lines.c_str());
+	remove(frames.c_str());
+
+	if (correct)
+		std::cout << "All events were logged correctly" << std::endl;
+	return correct ? 0 : 1;
+}
@@ -0,0 +1,136 @@
+#ifndef SERIALISABLE_PARALLEL_HPP
+#define SERIALISABLE_PARALLEL_HPP
+#include "serialisable.hpp"
+#include <thread>
+#include <condition_variable>
+
+/*!
+* \brief While it exists, large vectors, deques and hashtables of serialisable objects loaded by this thread are loaded by more threads
+*
+* \note Elements are loaded into storage prepared in advance, each by one thread, other threads only read the JSON
+* \note If loading an element throws, the exception of the element that would be loaded first is rethrown after all threads finish,
+* other elements may be loaded or not
+* \note Containers inside the elements are loaded by one thread, as are containers while shared objects are tracked
+* \note The elements must not depend on each other or on thread-local settings of this thread, JSON members of different elements
+* must not share strings (strings parsed while a StringInterner existed are shared)
+*/
+class ParallelDeserialisation {
+	struct Job {
+		void (*function)(void* context, size_t begin, size_t end);
+		void* context;
+		size_t count;
+		size_t rangeSize;
+		size_t ranges;
+		std::atomic<size_t> nextRange = {0};
+		std::vector<std::exception_ptr> errors;
+	};
+
+	SerialisableInternals::ParallelElements::Runner _previousRunner;
+	ParallelDeserialisation* _previous;
+	size_t _minimumElements;
+	bool _running = false;
+	std::vector<std::thread> _workers;
+	std::mutex _lock;
+	std::condition_variable _started;
+	std::condition_variable _finished;
+	Job* _job = nullptr; // Guarded by _lock
+	uint64_t _generation = 0; // Guarded by _lock
+	int _working = 0; // Workers that may still access the job, guarded by _lock
+	bool _stopping = false; // Guarded by _lock
+
+	static ParallelDeserialisation*& current() {
+		thread_local ParallelDeserialisation* instance = nullptr;
+		return instance;
+	}
+
+	static void work(Job& job) {
+		while (true) {
+			size_t range = job.nextRange.fetch_add(1);
+			if (range >= job.ranges)
+				return;
+			size_t begin = range * job.rangeSize;
+			try {
+				job.function(job.context, begin, std::min(begin + job.rangeSize, job.count));
+			} catch (...) {
+				job.errors[range] = std::current_exception();
+			}
+		}
+	}
+
+	void runWorker() {
+		uint64_t done = 0;
+		std::unique_lock<std::mutex> lock(_lock);
+		while (true) {
+			_started.wait(lock, [&] () { return _stopping || (_job && _generation != done); });
+			if (_stopping)
+				return;
+			done = _generation;
+			Job& job = *_job;
+			_working++;
+			lock.unlock();
+			work(job);
+			lock.lock();
+			_working--;
+			_finished.notify_all();
+		}
+	}
+
+	static bool run(size_t count, void (*function)(void* context, size_t begin, size_t end), void* context) {
+		ParallelDeserialisation* self = current();
+		if (!self || self->_running || count < self->_minimumElements || self->_workers.empty())
+			return false; // Elements containing large containers are loaded by one thread
+		self->_running = true;
+		Job job;
+		job.function = function;
+		job.context = context;
+		job.count = count;
+		job.rangeSize = std::max<size_t>(1, count / ((self->_workers.size() + 1) * 8)); // Small enough to balance uneven elements
+		job.ranges = (count + job.rangeSize - 1) / job.rangeSize;
+		job.errors.resize(job.ranges);
+		{
+			std::lock_guard<std::mutex> lock(self->_lock);
+			self->_job = &job;
+			self->_generation++;
+		}
+		self->_started.notify_all();
+		work(job);
+		{
+			std::unique_lock<std::mutex> lock(self->_lock);
+			self->_job = nullptr; // Workers that didn't start yet won't start
+			self->_finished.wait(lock, [&] () { return self->_working == 0; });
+		}
+		self->_running = false;
+		for (auto& it : job.errors)
+			if (it)
+				std::rethrow_exception(it);
+		return true;
+	}
+
+public:
+	/*!
+	* \brief Enables parallel loading in this thread and starts the threads
+	* \param Number of threads in total, including this one
+	* \param Containers with fewer elements are loaded by this thread only
+	*/
+	ParallelDeserialisation(unsigned int threads = std::thread::hardware_concurrency(), size_t minimumElements = 1024)
+			: _previousRunner(SerialisableInternals::ParallelElements::runner()), _previous(current()), _minimumElements(minimumElements) {
+		for (unsigned int i = 1; i < threads; i++)
+			_workers.emplace_back([this] () { runWorker(); });
+		current() = this;
+		SerialisableInternals::ParallelElements::runner() = &run;
+	}
+	ParallelDeserialisation(const ParallelDeserialisation&) = delete;
+	~ParallelDeserialisation() {
+		current() = _previous;
+		SerialisableInternals::ParallelElements::runner() = _previousRunner;
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_stopping = true;
+		}
+		_started.notify_all();
+		for (auto& it : _workers)
+			it.join();
+	}
+};
+
+#endif // SERIALISABLE_PARALLEL_HPP
@@ -0,0 +1,123 @@
+#include <iostream>
+#include "serialisable_parallel.hpp"
+
+struct Chapter : public Serialisable {
+	int id = 0;
+	std::string contents = "Lorem ipsum dolor sit amet";
+	double rating = 4.5;
+	std::vector<int> pages;
+	bool broken = false;
+
+	virtual void serialisation() {
+		synch("id", id);
+		synch("contents", contents);
+		synch("rating", rating);
+		synch("pages", pages);
+		synch("broken", broken);
+		if (broken)
+			throw std::runtime_error("Chapter " + std::to_string(id) + " is broken");
+	}
+};
+
+struct Book : public Serialisable {
+	std::vector<Chapter> chapters;
+	std::deque<Chapter> appendices;
+	std::unordered_map<std::string, Chapter> byName;
+
+	virtual void serialisation() {
+		synch("chapters", chapters);
+		synch("appendices", appendices);
+		synch("by_name", byName);
+	}
+};
+
+static bool sameChapters(const Chapter& first, const Chapter& second) {
+	return first.id == second.id && first.contents == second.contents && first.rating == second.rating && first.pages == second.pages;
+}
+
+static bool sameBooks(const Book& first, const Book& second) {
+	if (first.chapters.size() != second.chapters.size() || first.appendices.size() != second.appendices.size()
+			|| first.byName.size() != second.byName.size())
+		return false;
+	for (size_t i = 0; i < first.chapters.size(); i++)
+		if (!sameChapters(first.chapters[i], second.chapters[i]))
+			return false;
+	for (size_t i = 0; i < first.appendices.size(); i++)
+		if (!sameChapters(first.appendices[i], second.appendices[i]))
+			return false;
+	for (auto& it : first.byName) {
+		auto found = second.byName.find(it.first);
+		if (found == second.byName.end() || !sameChapters(it.second, found->second))
+			return false;
+	}
+	return true;
+}
+
+template <typename Function>
+static long long measure(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main() {
+	constexpr int CHAPTERS = 200000;
+	Book book;
+	book.chapters.resize(CHAPTERS);
+	for (int i = 0; i < CHAPTERS; i++) {
+		book.chapters[i].id = i;
+		book.chapters[i].pages.resize(i % 10, i);
+		if (i % 10 == 0)
+			book.appendices.push_back(book.chapters[i]);
+		if (i % 4 == 0)
+			book.byName["Chapter " + std::to_string(i)] = book.chapters[i];
+	}
+	Serialisable::JSON json = book.toJSON();
+	bool correct = true;
+
+	Book sequential;
+	std::cout << "Sequential load: " << measure([&] () { sequential.fromJSON(json); }) << " us" << std::endl;
+	for (unsigned int threads : { 2u, 4u, std::max(1u, std::thread::hardware_concurrency()) }) {
+		Book parallel;
+		long long time = measure([&] () {
+			ParallelDeserialisation enabled(threads);
+			parallel.fromJSON(json);
+		});
+		std::cout << "Parallel load with " << threads << " threads: " << time << " us" << std::endl;
+		if (!sameBooks(sequential, parallel)) {
+			std::cout << "Parallel load with " << threads << " threads loaded different data" << std::endl;
+			correct = false;
+		}
+		// Loading again reuses the elements
+		parallel.chapters[17].contents = "Changed";
+		{
+			ParallelDeserialisation enabled(threads);
+			parallel.fromJSON(json);
+		}
+		if (!sameBooks(sequential, parallel)) {
+			std::cout << "Parallel reload with " << threads << " threads loaded different data" << std::endl;
+			correct = false;
+		}
+	}
+
+	// The exception of the first broken element must come out, as if it was loaded sequentially
+	json["chapters"][size_t(150000)]["broken"].setBoolean(true);
+	json["chapters"][size_t(70000)]["broken"].setBoolean(true);
+	json["chapters"][size_t(120000)]["broken"].setBoolean(true);
+	try {
+		ParallelDeserialisation enabled(4);
+		Book broken;
+		broken.fromJSON(json);
+		std::cout << "Broken chapters were not noticed" << std::endl;
+		correct = false;
+	} catch (std::runtime_error& error) {
+		if (std::string(error.what()) != "Chapter 70000 is broken") {
+			std::cout << "Wrong exception: " << error.what() << std::endl;
+			correct = false;
+		}
+	}
+
+	if (correct)
+		std::cout << "Parallel loading works correctly" << std::endl;
+	return correct ? 0 : 1;
+}
@@ -5,46 +5,188 @@
 #include "generic_factory/generic_factory.hpp"
 
 struct SerialisablePolymorphic : public Serialisable, public SerialisableInternals::UnusualSerialisable {
-	constexpr static char typeMember[] = "type";
+	// The member holding the name of the class, a hierarchy can use a different one by declaring its own typeMember in its parent class
+	constexpr static const char* typeMember = "type";
+
+	virtual ~SerialisablePolymorphic() = default; // The objects are owned through pointers to their parents
+
+	/*!
+	* \brief Registers a class as a descendant of another one with a name, so that it's created when loading an object with that name
+	* \tparam The parent class, its typeMember is used for the name
+	* \tparam The child class
+	* \param The name
+	*
+	* \note Must not be called while anything is serialised, it's best done during static initialisation
+	*/
+	template <typename Parent, typename Child>
+	static void registerChild(const std::string& childName) {
+		GenericFactory<Parent>::template registerChild<Child>(childName);
+		if (strcmp(Parent::typeMember, typeMember) != 0)
+			typeMembers()[typeid(Child)] = Parent::typeMember;
+	}
+
+	/*!
+	* \brief Loads a polymorphic object from a JSON stream, the object is created as soon as its type is read
+	* and the other members are read when its serialisation() asks for them
+	* \param Pointer to the object, it's reused if it holds an object of the right class, it's emptied if the JSON is null
+	* \param The stream, it's positioned after the object afterwards
+	* \throw If the type is missing or unknown, or if the JSON is invalid
+	*
+	* \note If the type isn't the first member, the members before it are kept until it's found
+	* \note The values of the members are parsed whole, including polymorphic objects in them
+	*/
+	template <typename Pointer>
+	static void loadFromStream(Pointer& result, std::istream& stream);
+
 protected:
+	// Writes the name of the class as the first member, so that readers can create the right object before reading the rest
 	void subclass(const std::string& newName) {
-		if (saving())
-			synch(typeMember, const_cast<std::string&>(newName));
+		if (saving()) {
+			const char* member = typeMemberOf(typeid(*this));
+			synch(member, const_cast<std::string&>(newName));
+			leadWith(member);
+		}
 	}
 #if __cplusplus > 201402L
 	template <typename Parent, typename Child>
 	struct polymorphism {
 		polymorphism(const std::string& childName) {
-			GenericFactory<Parent>::template registerChild<Child>(childName);
+			registerChild<Parent, Child>(childName);
 		}
 		polymorphism(const char* childName) {
-			GenericFactory<Parent>::template registerChild<Child>(childName);
+			registerChild<Parent, Child>(childName);
 		}
 	};
 #define SERIALISABLE_REGISTER_POLYMORPHIC(PARENT, CHILD, CHILD_NAME) \
 	inline const static polymorphism<PARENT, CHILD> __polymorphism = CHILD_NAME;
 #endif
+
+private:
+	// Classes whose hierarchy doesn't use the default typeMember, filled when registering them
+	static std::unordered_map<std::type_index, const char*>& typeMembers() {
+		static std::unordered_map<std::type_index, const char*> instance;
+		return instance;
+	}
+	static const char* typeMemberOf(const std::type_info& type) {
+		auto& known = typeMembers();
+		if (known.empty())
+			return typeMember;
+		auto found = known.find(type);
+		return (found != known.end()) ? found->second : typeMember;
+	}
 };
 
 namespace SerialisableInternals {
 
+// Remembers which class was created for each type name, so that reloading into an object of the same class doesn't recreate it
+template <typename Serialised>
+struct PolymorphicTypes {
+	template <typename Pointer>
+	static void load(Pointer& result, const Serialisable::JSON& value) {
+		prepare(result, value);
+		result->fromJSON(value);
+	}
+
+	// Makes the pointer hold an object of the class named in the JSON, keeps the object if it's of that class already
+	template <typename Pointer>
+	static void prepare(Pointer& result, const Serialisable::JSON& value) {
+		const auto& object = value.object();
+		auto type = object.find(Serialised::typeMember);
+		if (type == object.end())
+			throw Serialisable::SerialisationError("Missing type information of polymorphic type");
+		create(result, type->second.string());
+	}
+
+	// Creates the object after reading the type, members read before it are kept and replayed to the object
+	template <typename Pointer>
+	static void load(Pointer& result, Serialisable::MemberSource& source) {
+		BufferedMembers buffered(source);
+		std::string name;
+		while (buffered.nextUnbuffered(name)) {
+			if (name == Serialised::typeMember) {
+				create(result, source.value().string());
+				result->fromMembers(buffered);
+				return;
+			}
+			buffered.keep(std::move(name), source.value());
+		}
+		throw Serialisable::SerialisationError("Missing type information of polymorphic type");
+	}
+
+private:
+	static std::unordered_map<std::string, std::type_index>& types() {
+		thread_local std::unordered_map<std::string, std::type_index> instance;
+		return instance;
+	}
+
+	template <typename Pointer>
+	static void create(Pointer& result, const std::string& name) {
+		auto& known = types();
+		auto found = known.find(name);
+		if (!result || found == known.end() || found->second != std::type_index(typeid(*result))) {
+			result = GenericFactory<Serialised>::createChild(name);
+			if (found == known.end())
+				known.emplace(name, std::type_index(typeid(*result)));
+		}
+	}
+
+	// Gives the members kept while looking for the type first, then the rest from the source
+	class BufferedMembers : public Serialisable::MemberSource {
+		Serialisable::MemberSource& _source;
+		std::vector<std::pair<std::string, Serialisable::JSON>> _kept;
+		size_t _replayed = 0;
+	public:
+		BufferedMembers(Serialisable::MemberSource& source) : _source(source) { }
+		bool nextUnbuffered(std::string& name) {
+			return _source.nextName(name);
+		}
+		void keep(std::string&& name, Serialisable::JSON&& value) {
+			_kept.emplace_back(std::move(name), std::move(value));
+		}
+		bool nextName(std::string& name) override {
+			if (_replayed < _kept.size()) {
+				name = _kept[_replayed].first;
+				return true;
+			}
+			return _source.nextName(name);
+		}
+		Serialisable::JSON value() override {
+			if (_replayed < _kept.size())
+				return std::move(_kept[_replayed++].second);
+			return _source.value();
+		}
+	};
+};
+
 template <typename Serialised>
 struct Serialiser<std::shared_ptr<Serialised>, std::enable_if_t<std::is_base_of<SerialisablePolymorphic, Serialised>::value>> {
 	constexpr static bool valid = true;
 
 	static Serialisable::JSON serialise(const std::shared_ptr<Serialised>& value) {
-		if (value)
-			return value->toJSON();
-		else
+		if (!value)
 			return Serialisable::JSON(); // null
+		SharedObjectTracking* tracking = SharedObjectTracking::current();
+		if (tracking) // Identified by the whole object, so that pointers to different bases of it are recognised
+			return tracking->save(dynamic_cast<const void*>(value.get()), [&] () {
+				return value->toJSON();
+			}, true);
+		return value->toJSON();
 	}
 
-	static void deserialise(std::shared_ptr<Serialised>& result, Serialisable::JSON value) {
-		auto type = value.object().find(SerialisablePolymorphic::typeMember);
-		if (type == value.object().end())
-			throw Serialisable::SerialisationError("Missing type information of polymorphic type");
-		result = GenericFactory<Serialised>::createChild(type->second.string());
-		result->fromJSON(value);
+	static void deserialise(std::shared_ptr<Serialised>& result, const Serialisable::JSON& value) {
+		SharedObjectTracking* tracking = SharedObjectTracking::current();
+		if (value.type() == Serialisable::JSON::Type::NIL)
+			result = nullptr;
+		else if (tracking && value.type() == Serialisable::JSON::Type::OBJECT)
+			tracking->load(result, value, [] (Serialised& loaded, const Serialisable::JSON& contents) {
+				loaded.fromJSON(contents);
+			}, [] (std::shared_ptr<Serialised>& made, const Serialisable::JSON* contents) {
+				if (!contents)
+					throw Serialisable::SerialisationError("Polymorphic shared object referenced before its definition");
+				PolymorphicTypes<Serialised>::prepare(made, *contents);
+			});
+		else
+			PolymorphicTypes<Serialised>::load(result, value);
 	}
 };
 
@@ -59,15 +201,29 @@ struct Serialiser<std::unique_ptr<Serialised>, std::enable_if_t<std::is_base_of<
 			return Serialisable::JSON(); // null
 	}
 
-	static void deserialise(std::unique_ptr<Serialised>& result, Serialisable::JSON value) {
-		auto type = value.object().find(SerialisablePolymorphic::typeMember);
-		if (type == value.object().end())
-			throw Serialisable::SerialisationError("Missing type information of polymorphic type");
-		result = GenericFactory<Serialised>::createChild(type->second.string());
-		result->fromJSON(value);
+	static void deserialise(std::unique_ptr<Serialised>& result, const Serialisable::JSON& value) {
+		if (value.type() == Serialisable::JSON::Type::NIL)
+			result = nullptr;
+		else
+			PolymorphicTypes<Serialised>::load(result, value);
 	}
 };
 
 }
 
+template <typename Pointer>
+void SerialisablePolymorphic::loadFromStream(Pointer& result, std::istream& stream) {
+	using Serialised = typename Pointer::element_type;
+	static_assert(std::is_base_of<SerialisablePolymorphic, Serialised>::value, "Only polymorphic objects can be loaded this way");
+	char letter = SerialisableInternals::JSONformat::readWhitespace(stream);
+	stream.unget();
+	if (letter == 'n') {
+		SerialisableInternals::JSONformat::fromStream(stream);
+		result = nullptr;
+		return;
+	}
+	SerialisableInternals::JSONformat::MemberReader reader(stream);
+	SerialisableInternals::PolymorphicTypes<Serialised>::load(result, reader);
+}
+
 #endif // SERIALISABLE_POLYMORPHIC_HPP
@@ -0,0 +1,170 @@
+#ifndef SERIALISABLE_PUBLISHER_HPP
+#define SERIALISABLE_PUBLISHER_HPP
+#include "serialisable.hpp"
+#include <thread>
+
+namespace SerialisableInternals {
+
+// Finds the position of a format in the list of published formats
+template <typename Wanted, typename... Formats>
+struct FormatIndex;
+
+template <typename Wanted, typename... Others>
+struct FormatIndex<Wanted, Wanted, Others...> {
+	constexpr static size_t value = 0;
+};
+
+template <typename Wanted, typename First, typename... Others>
+struct FormatIndex<Wanted, First, Others...> {
+	constexpr static size_t value = FormatIndex<Wanted, Others...>::value + 1;
+};
+
+} // namespace
+
+/*!
+* \brief Keeps the latest serialised state of an object for many reader threads
+* \tparam The formats it's published in, like SerialisableInternals::JSONformat or CondensedJSON
+*
+* \note The writer serialises the object once per change, readers only take a reference to the result
+* \note Reading is wait-free, publishing waits until readers that may have seen the previous state got their reference
+*/
+template <typename... Formats>
+class SerialisablePublisher {
+	static_assert(sizeof...(Formats) > 0, "At least one format must be published");
+
+	struct Contents {
+		std::tuple<decltype(std::declval<const ISerialisable&>().to<Formats>())...> serialised;
+		uint64_t version = 0;
+		std::atomic<uint32_t> references = {1};
+
+		Contents(const ISerialisable& source) : serialised(source.to<Formats>()...) { }
+	};
+
+	static void release(Contents* contents) {
+		if (contents && contents->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			delete contents;
+	}
+
+	// Readers announce themselves in one of these counters while they take a reference
+	// Counters are picked by thread, so that readers of different threads don't fight over one cache line
+	constexpr static int READER_SLOTS = 32;
+	struct alignas(64) ReaderSlot {
+		std::atomic<uint32_t> inside = {0};
+	};
+	mutable std::array<std::array<ReaderSlot, READER_SLOTS>, 2> _readers;
+	std::atomic<uint32_t> _epoch = {0};
+	std::atomic<Contents*> _current = {nullptr};
+	std::mutex _writing;
+	uint64_t _version = 0;
+
+	static int readerSlot() {
+		static std::atomic<int> assigned = {0};
+		thread_local int slot = assigned.fetch_add(1, std::memory_order_relaxed) % READER_SLOTS;
+		return slot;
+	}
+
+	// Waits until no reader may still be taking a reference to a replaced snapshot
+	// The epoch is flipped twice because a slow reader may have read the epoch before the previous flip
+	void synchronise() {
+		for (int phase = 0; phase < 2; phase++) {
+			uint32_t previous = _epoch.fetch_add(1) & 1;
+			for (ReaderSlot& slot : _readers[previous]) {
+				while (slot.inside.load() != 0)
+					std::this_thread::yield();
+			}
+		}
+	}
+
+public:
+	/*!
+	* \brief A reference to one published state, it stays valid even if newer states are published
+	*/
+	class Snapshot {
+		Contents* _contents = nullptr;
+		explicit Snapshot(Contents* contents) : _contents(contents) { }
+		friend class SerialisablePublisher;
+	public:
+		Snapshot() = default;
+		Snapshot(const Snapshot& other) : _contents(other._contents) {
+			if (_contents)
+				_contents->references.fetch_add(1, std::memory_order_relaxed);
+		}
+		Snapshot(Snapshot&& other) : _contents(other._contents) {
+			other._contents = nullptr;
+		}
+		Snapshot& operator=(Snapshot other) {
+			std::swap(_contents, other._contents);
+			return *this;
+		}
+		~Snapshot() {
+			release(_contents);
+		}
+
+		/*!
+		* \brief Returns the state serialised in a given format
+		* \tparam The format, must be one of the published formats
+		* \return The serialised state, as returned by the format's serialise()
+		*/
+		template <typename Format>
+		const auto& get() const {
+			return std::get<SerialisableInternals::FormatIndex<Format, Formats...>::value>(_contents->serialised);
+		}
+
+		/*!
+		* \brief Returns how many times the state was published before this one, to recognise changes
+		*/
+		uint64_t version() const {
+			return _contents->version;
+		}
+
+		explicit operator bool() const {
+			return _contents;
+		}
+	};
+
+	SerialisablePublisher() = default;
+	SerialisablePublisher(const SerialisablePublisher&) = delete;
+	SerialisablePublisher& operator=(const SerialisablePublisher&) = delete;
+	~SerialisablePublisher() {
+		release(_current.load());
+	}
+
+	/*!
+	* \brief Serialises the object in all formats and makes it the latest state
+	* \param The object, it must not be changed until this returns
+	* \return False if it serialises into the same as the latest state, which is then kept
+	*
+	* \note It calls the overloaded serialisation() method
+	* \note Publishing from more threads is serialised by a mutex
+	*/
+	bool publish(const ISerialisable& source) {
+		std::lock_guard<std::mutex> lock(_writing);
+		std::unique_ptr<Contents> made = std::make_unique<Contents>(source);
+		Contents* previous = _current.load();
+		if (previous && previous->serialised == made->serialised)
+			return false;
+		made->version = _version++;
+		_current.store(made.release());
+		synchronise();
+		release(previous);
+		return true;
+	}
+
+	/*!
+	* \brief Returns the latest published state
+	* \return The snapshot, empty if nothing was published yet
+	*
+	* \note Wait-free, can be called from any number of threads
+	*/
+	Snapshot latest() const {
+		std::atomic<uint32_t>& inside = _readers[_epoch.load() & 1][readerSlot()].inside;
+		inside.fetch_add(1);
+		Contents* contents = _current.load();
+		if (contents)
+			contents->references.fetch_add(1, std::memory_order_relaxed);
+		inside.fetch_sub(1);
+		return Snapshot(contents);
+	}
+};
+
+#endif // SERIALISABLE_PUBLISHER_HPP
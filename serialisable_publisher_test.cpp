@@ -0,0 +1,71 @@
+#include <iostream>
+#include "serialisable_publisher.hpp"
+#include "condensed_json.hpp"
+
+struct Status : public Serialisable {
+	std::string state = "starting";
+	int64_t requestsServed = 0;
+	std::vector<int> latencies;
+
+	virtual void serialisation() {
+		synch("state", state);
+		synch("requests_served", requestsServed);
+		synch("latencies", latencies);
+	}
+};
+
+int main() {
+	constexpr int updates = 2000;
+	SerialisablePublisher<SerialisableInternals::JSONformat, CondensedJSON> publisher;
+	if (publisher.latest()) {
+		std::cout << "Publisher had a state before anything was published" << std::endl;
+		return 1;
+	}
+
+	Status status;
+	publisher.publish(status);
+	if (publisher.publish(status)) {
+		std::cout << "Publishing an unchanged state made a new snapshot" << std::endl;
+		return 1;
+	}
+
+	std::atomic<bool> failed = {false};
+	std::atomic<int> finished = {0};
+	std::vector<std::thread> readers;
+	for (int i = 0; i < 4; i++) {
+		readers.emplace_back([&] {
+			uint64_t lastVersion = 0;
+			Status seen;
+			while (seen.requestsServed < updates) {
+				auto snapshot = publisher.latest();
+				if (snapshot.version() < lastVersion)
+					failed = true;
+				lastVersion = snapshot.version();
+				seen.fromString(snapshot.get<SerialisableInternals::JSONformat>());
+				Status condensed;
+				condensed.from<CondensedJSON>(snapshot.get<CondensedJSON>());
+				if (seen.requestsServed != int64_t(snapshot.version()) || condensed.requestsServed != seen.requestsServed
+						|| seen.latencies.size() != size_t(seen.requestsServed))
+					failed = true;
+			}
+			finished++;
+		});
+	}
+
+	status.state = "running";
+	for (int i = 1; i <= updates; i++) {
+		status.requestsServed = i;
+		status.latencies.push_back(i % 7);
+		publisher.publish(status);
+	}
+	for (auto& it : readers)
+		it.join();
+
+	auto last = publisher.latest();
+	if (failed || finished != 4 || last.version() != updates) {
+		std::cout << "Readers did not see consistent snapshots" << std::endl;
+		return 1;
+	}
+	std::cout << "Last published state: " << last.get<SerialisableInternals::JSONformat>() << std::endl;
+	return 0;
+}
@@ -58,67 +58,97 @@ struct FakeObjectInspector {
 	}
 };
 
-// Partial template specialisation for recursively finding member count, initialising with more and more variables
-template <typename T, typename sfinae, size_t... indexes>
-struct MemberCounter {
-	constexpr static size_t get() {
-		return sizeof...(indexes) - 1;
-	}
-};
+// Checks if T can be initialised with a given number of inspectors, the fake one is for the base class
+template <typename T, typename Indexes, typename sfinae = void>
+struct ConstructibleWithInspectors : std::false_type {};
 
 template <typename T, size_t... indexes>
-struct MemberCounter<T, decltype( T { {FakeObjectInspector()}, ObjectInspector<T, indexes>()...} )*, indexes...> {
+struct ConstructibleWithInspectors<T, std::index_sequence<indexes...>,
+		std::void_t<decltype( T { {FakeObjectInspector()}, ObjectInspector<T, indexes>()...} )>> : std::true_type {};
+
+template <typename T, size_t count>
+constexpr bool constructibleWith = ConstructibleWithInspectors<T, std::make_index_sequence<count>>::value;
+
+// Bisection between a count that is known to be constructible and one that is known not to be
+template <typename T, size_t lower, size_t upper, bool done = (upper - lower <= 1)>
+struct MemberCountBisection {
+	constexpr static size_t middle = lower + (upper - lower) / 2;
+	constexpr static size_t value = std::conditional_t<constructibleWith<T, middle>,
+			MemberCountBisection<T, middle, upper>, MemberCountBisection<T, lower, middle>>::value;
+};
+
+template <typename T, size_t lower, size_t upper>
+struct MemberCountBisection<T, lower, upper, true> {
+	constexpr static size_t value = lower;
+};
+
+// Doubles the count until it's too many, so only a logarithmic number of initialisations is tried
+template <typename T, size_t bound, bool fits = constructibleWith<T, bound>>
+struct MemberCountSearch {
+	static_assert(bound < (size_t(1) << 20), "SerialisableQuick failed to detect the number of members");
+	constexpr static size_t value = MemberCountSearch<T, bound * 2>::value;
+};
+
+template <typename T, size_t bound>
+struct MemberCountSearch<T, bound, false> {
+	constexpr static size_t value = MemberCountBisection<T, bound / 2, bound>::value;
+};
+
+template <typename T, typename sfinae = T*>
+struct MemberCounter {
 	constexpr static size_t get() {
-		return MemberCounter<T, T*, indexes..., sizeof...(indexes)>::get();
+		return MemberCountSearch<T, 1>::value;
 	}
 };
 
-// Calculation of padding, assuming all composite types contain word-sized members
-// True for std::string, smart pointers and all STL containers (NOT std::array)
-// Should use something specialised for all supported types in the final version
-template <size_t previous, size_t alignment>
-constexpr size_t padded() {
+constexpr size_t padded(size_t previous, size_t alignment) {
 	return previous % alignment ? previous - (previous % alignment) + alignment : previous;
 }
 
-template <typename T, size_t index, size_t offset>
-constexpr size_t getPaddedOffset() {
-	constexpr size_t size = memberSize(ObjectGetter<T, index>{});
-	constexpr size_t alignment = memberAlignment(ObjectGetter<T, index>{});
-	constexpr size_t paddedOffset = padded<offset, alignment>();
-	return paddedOffset;
+// Offsets of all members, computed in a loop rather than through recursive instantiations
+template <typename T, size_t start, size_t... indexes>
+constexpr std::array<size_t, sizeof...(indexes)> memberOffsets(std::index_sequence<indexes...>) {
+	constexpr std::array<size_t, sizeof...(indexes)> sizes = { size_t(memberSize(ObjectGetter<T, indexes>{}))... };
+	constexpr std::array<size_t, sizeof...(indexes)> alignments = { size_t(memberAlignment(ObjectGetter<T, indexes>{}))... };
+	std::array<size_t, sizeof...(indexes)> offsets = {};
+	size_t offset = start;
+	for (size_t i = 0; i < sizeof...(indexes); i++) {
+		offset = padded(offset, alignments[i]);
+		offsets[i] = offset;
+		offset += sizes[i];
+	}
+	return offsets;
 }
 
-
-// Iteration through all elements, the first overload stops the recursion
-template <typename T, size_t offset>
-void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<>) { }
-
-template <typename T, size_t offset, size_t index, size_t... otherIndexes>
-void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<index, otherIndexes...>) {
-	constexpr size_t paddedOffset = getPaddedOffset<T, index, offset>();
+template <typename T, size_t index>
+void serialiseNamedMember(const T* instance, Serialisable::JSON& output, size_t offset) {
 	const char* name = T::memberName(index);
 	if (name)
-		output[name] = serialiseMember(ObjectGetter<T, index>{}, instance, paddedOffset);
-	serialiseMembers<T, paddedOffset + memberSize(ObjectGetter<T, index>{})>(instance, output, std::index_sequence<otherIndexes...>{});
+		output[name] = serialiseMember(ObjectGetter<T, index>{}, instance, offset);
 }
 
-// Same, for deserialisation
-
-// Iteration through all elements, the first overload stops the recursion
-template <typename T, size_t offset>
-void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<>) { }
-
-template <typename T, size_t offset, size_t index, size_t... otherIndexes>
-void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<index, otherIndexes...>) {
-	constexpr size_t paddedOffset = getPaddedOffset<T, index, offset>();
+template <typename T, size_t index>
+void deserialiseNamedMember(T* instance, const Serialisable::JSON& input, size_t offset) {
 	const char* name = T::memberName(index);
 	if (name) {
 		const auto& found = input.object().find(name);
 		if (found != input.object().end())
-			deserialiseMember(ObjectGetter<T, index>{}, instance, paddedOffset, found->second);
+			deserialiseMember(ObjectGetter<T, index>{}, instance, offset, found->second);
 	}
-	deserialiseMembers<T, paddedOffset + memberSize(ObjectGetter<T, index>{})>(instance, input, std::index_sequence<otherIndexes...>{});
+}
+
+// Iteration through all elements
+template <typename T, size_t start, size_t... indexes>
+void serialiseMembers(const T* instance, Serialisable::JSON& output, std::index_sequence<indexes...>) {
+	constexpr std::array<size_t, sizeof...(indexes)> offsets = memberOffsets<T, start>(std::index_sequence<indexes...>{});
+	(serialiseNamedMember<T, indexes>(instance, output, offsets[indexes]), ...);
+}
+
+// Same, for deserialisation
+template <typename T, size_t start, size_t... indexes>
+void deserialiseMembers(T* instance, const Serialisable::JSON& input, std::index_sequence<indexes...>) {
+	constexpr std::array<size_t, sizeof...(indexes)> offsets = memberOffsets<T, start>(std::index_sequence<indexes...>{});
+	(deserialiseNamedMember<T, indexes>(instance, input, offsets[indexes]), ...);
 }
 
 // Same, for mapping ranges where members are saved
@@ -134,15 +164,14 @@ struct MappingInfo {
 	Child* instance;
 };
 
-template <typename T, size_t offset>
-void mapLayout(MappingInfo<T>* output, std::index_sequence<>) { }
-
-template <typename T, size_t offset, size_t index, size_t... otherIndexes>
-void mapLayout(MappingInfo<T>* output, std::index_sequence<index, otherIndexes...>) {
-	constexpr size_t paddedOffset = getPaddedOffset<T, index, offset>();
-	output->elementStarts[index] = paddedOffset;
-	output->elementSizes[index] = memberSize(ObjectGetter<T, index>{});
-	mapLayout<T, paddedOffset + memberSize(ObjectGetter<T, index>{})>(output, std::index_sequence<otherIndexes...>{});	
+template <typename T, size_t start, size_t... indexes>
+void mapLayout(MappingInfo<T>* output, std::index_sequence<indexes...>) {
+	constexpr std::array<size_t, sizeof...(indexes)> offsets = memberOffsets<T, start>(std::index_sequence<indexes...>{});
+	constexpr std::array<int, sizeof...(indexes)> sizes = { memberSize(ObjectGetter<T, indexes>{})... };
+	for (size_t i = 0; i < sizeof...(indexes); i++) {
+		output->elementStarts[i] = offsets[i];
+		output->elementSizes[i] = sizes[i];
+	}
 }
 
 } // namespace
@@ -205,6 +234,7 @@ public:
 	SerialisableQuick() {
 		using namespace SerialisableQuickInternals;
 		if (_initialisationState == InitialisationState::UNINITIALISED) {
+			SERIALISABLE_BY_DUGI_TRACE_SPAN("layout", SerialisableInternals::Tracing::typeName(typeid(Child)) + " layout discovery");
 			// Prepare stuff
 			_initialisationState = InitialisationState::INITIALISING;
 			MappingInfo<Child> mappingInfo;
@@ -369,16 +399,18 @@ SerialisableQuick<Child>::Assigner<named, Args...>::operator Made() const {
 			while (reinterpret_cast<int8_t*>(mappingInfo->instance)[lastUninitialised] == garbageNumber && lastUninitialised)
 				lastUninitialised--;
 			
-			int lastInitialised = -1;
-			for (int i = 0; i < mappingInfo->size; i++) {
-				if (mappingInfo->elementStarts[i] > lastUninitialised - mappingInfo->elementSizes[i]) {
-					lastInitialised = i;
-					break;
+			int lastInitialised = -1; // Stays so if no member was initialised yet, then this is the first one
+			if (reinterpret_cast<int8_t*>(mappingInfo->instance)[lastUninitialised] != garbageNumber) {
+				for (int i = 0; i < mappingInfo->size; i++) {
+					if (mappingInfo->elementStarts[i] > lastUninitialised - mappingInfo->elementSizes[i]) {
+						lastInitialised = i;
+						break;
+					}
 				}
+				//std::cout << "Snapshot last uninit " << lastUninitialised << " last init " << lastInitialised << std::endl;
+				if (lastInitialised == -1)
+					throw std::logic_error("Failed to map class initialisation");
 			}
-			//std::cout << "Snapshot last uninit " << lastUninitialised << " last init " << lastInitialised << std::endl;
-			if (lastInitialised == -1)
-				throw std::logic_error("Failed to map class initialisation");
 			
 			if (state == State::INITIALISING)
 				mappingInfo->lastInitialisedBefore1[mappingInfo->namedSoFar] = lastInitialised;
@@ -0,0 +1,386 @@
+#ifndef SERIALISABLE_SHM_HPP
+#define SERIALISABLE_SHM_HPP
+#include "serialisable.hpp"
+#include <thread>
+#include <cerrno>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace SerialisableInternals {
+
+// Writes into a fixed range of memory, keeps counting the size if it doesn't fit
+class BoundedSink {
+	uint8_t* _position;
+	uint8_t* _end;
+	size_t _size = 0;
+public:
+	BoundedSink(uint8_t* start, size_t capacity) : _position(start), _end(start + capacity) { }
+
+	void push_back(uint8_t value) {
+		if (_position != _end)
+			*_position++ = value;
+		_size++;
+	}
+	size_t size() const {
+		return _size;
+	}
+};
+
+} // namespace
+
+/*!
+* \brief A ring buffer in shared memory, through which serialised objects can be sent to another process
+*
+* \note One process reads, one or more processes write (more writers must be allowed when creating it)
+* \note Binary formats that have serialiseInto() encode directly into the shared memory, formats with deserialiseBytes() decode it in place
+* \note Waiting for space or messages is done by yielding, it's meant for processes that exchange messages often
+*/
+class SharedMemoryRing {
+	constexpr static uint64_t MAGIC = 0x676e6952646c6853; // "ShldRing"
+	constexpr static uint64_t WRAP = UINT64_MAX; // Record size meaning that the rest of the ring is skipped
+	constexpr static size_t RECORD_HEADER = sizeof(uint64_t);
+
+	struct Header {
+		std::atomic<uint64_t> magic;
+		uint64_t capacity;
+		bool multipleProducers;
+		alignas(64) std::atomic<uint64_t> written;
+		alignas(64) std::atomic<uint64_t> read;
+		alignas(64) std::atomic<bool> producing;
+	};
+
+	std::string _name;
+	pid_t _creator = 0;
+	Header* _header = nullptr;
+	uint8_t* _data = nullptr;
+	size_t _mapped = 0;
+	std::vector<uint8_t> _spare;
+
+	// Holds the right to write if there can be more writers
+	class ProducerLock {
+		Header* _locked;
+	public:
+		ProducerLock(Header* header) : _locked(header->multipleProducers ? header : nullptr) {
+			if (_locked) {
+				while (_locked->producing.exchange(true, std::memory_order_acquire))
+					std::this_thread::yield();
+			}
+		}
+		ProducerLock(const ProducerLock&) = delete;
+		~ProducerLock() {
+			if (_locked)
+				_locked->producing.store(false, std::memory_order_release);
+		}
+	};
+
+	static size_t recordSize(size_t size) {
+		return (RECORD_HEADER + size + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+	}
+
+	size_t freeSpace(uint64_t written) const {
+		return _header->capacity - (written - _header->read.load(std::memory_order_acquire));
+	}
+
+	void map(int descriptor, size_t size) {
+		void* mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | (descriptor < 0 ? MAP_ANONYMOUS : 0), descriptor, 0);
+		if (mapped == MAP_FAILED)
+			throw std::runtime_error("Could not map shared memory " + _name + ": " + strerror(errno));
+		_mapped = size;
+		_header = reinterpret_cast<Header*>(mapped);
+		_data = reinterpret_cast<uint8_t*>(mapped) + sizeof(Header);
+	}
+
+	void initialise(size_t capacity, bool multipleProducers) {
+		new (_header) Header();
+		_header->capacity = capacity;
+		_header->multipleProducers = multipleProducers;
+		_header->written = 0;
+		_header->read = 0;
+		_header->producing = false;
+		_header->magic.store(MAGIC, std::memory_order_release);
+	}
+
+	static size_t roundedCapacity(size_t capacity) {
+		size_t rounded = 64;
+		while (rounded < capacity)
+			rounded <<= 1;
+		return rounded;
+	}
+
+	void commit(uint64_t written, size_t offset, size_t size) {
+		*reinterpret_cast<uint64_t*>(_data + offset) = size;
+		_header->written.store(written + recordSize(size), std::memory_order_release);
+	}
+
+	// Copies an already serialised message, waiting until there is space for it
+	void writeBytes(const uint8_t* bytes, size_t size) {
+		const size_t required = recordSize(size);
+		if (required > _header->capacity)
+			throw Serialisable::SerialisationError("Message of " + std::to_string(size) + " bytes doesn't fit into shared memory ring " + _name);
+		while (true) {
+			uint64_t written = _header->written.load(std::memory_order_relaxed);
+			size_t offset = written & (_header->capacity - 1);
+			size_t untilEnd = _header->capacity - offset;
+			size_t available = freeSpace(written);
+			if (untilEnd < required) {
+				if (available >= untilEnd) {
+					*reinterpret_cast<uint64_t*>(_data + offset) = WRAP;
+					_header->written.store(written + untilEnd, std::memory_order_release);
+					continue;
+				}
+			} else if (available >= required) {
+				memcpy(_data + offset + RECORD_HEADER, bytes, size);
+				commit(written, offset, size);
+				return;
+			}
+			std::this_thread::yield();
+		}
+	}
+
+	template <typename Format>
+	static void encodeInto(const Serialisable::JSON& source, SerialisableInternals::BoundedSink& sink, std::true_type) {
+		Format::serialiseInto(source, sink);
+	}
+	template <typename Format>
+	static void encodeInto(const Serialisable::JSON&, SerialisableInternals::BoundedSink&, std::false_type) { }
+
+	template <typename Format>
+	static void encodeSpare(const Serialisable::JSON& source, std::vector<uint8_t>& spare, std::true_type) {
+		Format::serialiseInto(source, spare);
+	}
+	template <typename Format>
+	static void encodeSpare(const Serialisable::JSON& source, std::vector<uint8_t>& spare, std::false_type) {
+		auto made = Format::serialise(source);
+		spare.insert(spare.end(), std::begin(made), std::end(made));
+	}
+
+	SharedMemoryRing() = default;
+
+public:
+	/*!
+	* \brief Creates a new ring in named shared memory, replacing any ring of the same name
+	* \param The name, starting with a slash, as in shm_open()
+	* \param The capacity in bytes, rounded up to a power of two
+	* \param If more processes are allowed to write into it
+	* \return The ring
+	* \throw If the shared memory can't be created
+	*
+	* \note The shared memory is unlinked when the creating process destroys the ring
+	*/
+	static SharedMemoryRing create(const std::string& name, size_t capacity, bool multipleProducers = false) {
+		SharedMemoryRing made;
+		made._name = name;
+		capacity = roundedCapacity(capacity);
+		shm_unlink(name.c_str());
+		int descriptor = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+		if (descriptor < 0)
+			throw std::runtime_error("Could not create shared memory " + name + ": " + strerror(errno));
+		if (ftruncate(descriptor, sizeof(Header) + capacity) != 0) {
+			int error = errno;
+			close(descriptor);
+			shm_unlink(name.c_str());
+			throw std::runtime_error("Could not resize shared memory " + name + ": " + strerror(error));
+		}
+		made._creator = getpid();
+		try {
+			made.map(descriptor, sizeof(Header) + capacity);
+		} catch (...) {
+			close(descriptor);
+			throw;
+		}
+		close(descriptor);
+		made.initialise(capacity, multipleProducers);
+		return made;
+	}
+
+	/*!
+	* \brief Creates a new ring in unnamed shared memory, it can be used by child processes created by fork()
+	* \param The capacity in bytes, rounded up to a power of two
+	* \param If more processes are allowed to write into it
+	* \return The ring
+	* \throw If the shared memory can't be created
+	*/
+	static SharedMemoryRing create(size_t capacity, bool multipleProducers = false) {
+		SharedMemoryRing made;
+		capacity = roundedCapacity(capacity);
+		made.map(-1, sizeof(Header) + capacity);
+		made.initialise(capacity, multipleProducers);
+		return made;
+	}
+
+	/*!
+	* \brief Opens a ring created by another process
+	* \param The name used when creating it
+	* \return The ring
+	* \throw If it doesn't exist or isn't a ring
+	*/
+	static SharedMemoryRing open(const std::string& name) {
+		SharedMemoryRing made;
+		made._name = name;
+		int descriptor = shm_open(name.c_str(), O_RDWR, 0600);
+		if (descriptor < 0)
+			throw std::runtime_error("Could not open shared memory " + name + ": " + strerror(errno));
+		struct stat status;
+		if (fstat(descriptor, &status) != 0 || size_t(status.st_size) <= sizeof(Header)) {
+			close(descriptor);
+			throw std::runtime_error("Shared memory " + name + " is not a ring");
+		}
+		try {
+			made.map(descriptor, status.st_size);
+		} catch (...) {
+			close(descriptor);
+			throw;
+		}
+		close(descriptor);
+		if (made._header->magic.load(std::memory_order_acquire) != MAGIC || made._header->capacity + sizeof(Header) != made._mapped)
+			throw std::runtime_error("Shared memory " + name + " is not a ring");
+		return made;
+	}
+
+	SharedMemoryRing(SharedMemoryRing&& other) : _name(std::move(other._name)), _creator(other._creator), _header(other._header),
+			_data(other._data), _mapped(other._mapped), _spare(std::move(other._spare)) {
+		other._header = nullptr;
+		other._creator = 0;
+	}
+	SharedMemoryRing(const SharedMemoryRing&) = delete;
+	SharedMemoryRing& operator=(const SharedMemoryRing&) = delete;
+	~SharedMemoryRing() {
+		if (_header)
+			munmap(_header, _mapped);
+		if (_creator == getpid() && !_name.empty())
+			shm_unlink(_name.c_str());
+	}
+
+	/*!
+	* \brief Serialises an object into the ring, waits if there's not enough space
+	* \tparam The format, a binary one is expected
+	* \param The object
+	* \throw If the message is larger than the ring
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	template <typename Format>
+	void write(const ISerialisable& source) {
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		write<Format>(source.toJSON());
+	}
+
+	/*!
+	* \brief Serialises a JSON into the ring, waits if there's not enough space
+	* \tparam The format, a binary one is expected
+	* \param The JSON
+	* \throw If the message is larger than the ring
+	*
+	* \note If the format has serialiseInto() and there is enough contiguous space, it's written without an intermediate buffer
+	*/
+	template <typename Format>
+	void write(const Serialisable::JSON& source) {
+		using Direct = SerialisableInternals::WritesIntoSink<Format, SerialisableInternals::BoundedSink>;
+		ProducerLock lock(_header);
+		uint64_t written = _header->written.load(std::memory_order_relaxed);
+		size_t offset = written & (_header->capacity - 1);
+		size_t contiguous = std::min(freeSpace(written), size_t(_header->capacity - offset));
+		if (Direct::value && contiguous > RECORD_HEADER) {
+			SerialisableInternals::BoundedSink sink(_data + offset + RECORD_HEADER, contiguous - RECORD_HEADER);
+			encodeInto<Format>(source, sink, Direct());
+			if (sink.size() <= contiguous - RECORD_HEADER) {
+				commit(written, offset, sink.size());
+				return;
+			}
+		}
+		_spare.clear();
+		encodeSpare<Format>(source, _spare, SerialisableInternals::WritesIntoSink<Format, std::vector<uint8_t>>());
+		writeBytes(_spare.data(), _spare.size());
+	}
+
+	/*!
+	* \brief Gives the oldest message to a function without copying it, then removes it from the ring
+	* \param A function taking a const uint8_t* to the data and a size_t with their size
+	* \return False if there was no message
+	*
+	* \note The data must not be used after the function returns, the message is removed even if it throws
+	*/
+	template <typename Reader>
+	bool tryReadBytes(Reader&& reader) {
+		uint64_t read = _header->read.load(std::memory_order_relaxed);
+		while (read != _header->written.load(std::memory_order_acquire)) {
+			size_t offset = read & (_header->capacity - 1);
+			uint64_t size = *reinterpret_cast<const uint64_t*>(_data + offset);
+			if (size == WRAP) {
+				read += _header->capacity - offset;
+				_header->read.store(read, std::memory_order_release);
+				continue;
+			}
+			struct Consumer { // Frees the space even if the reader throws
+				Header* header;
+				uint64_t next;
+				~Consumer() {
+					header->read.store(next, std::memory_order_release);
+				}
+			} consumer = { _header, read + recordSize(size) };
+			reader(static_cast<const uint8_t*>(_data + offset + RECORD_HEADER), size_t(size));
+			return true;
+		}
+		return false;
+	}
+
+	/*!
+	* \brief Reads the oldest message into a JSON
+	* \tparam The format it was written in
+	* \param The JSON to overwrite with the message
+	* \return False if there was no message
+	* \throw If the message isn't valid
+	*
+	* \note If the format has deserialiseBytes(), the data are parsed directly from the shared memory
+	*/
+	template <typename Format>
+	bool tryRead(Serialisable::JSON& result) {
+		return tryReadBytes([&] (const uint8_t* data, size_t size) {
+			result = SerialisableInternals::BytesDecoder<Format>::decode(data, size);
+		});
+	}
+
+	/*!
+	* \brief Reads the oldest message into an object
+	* \tparam The format it was written in
+	* \param The object
+	* \return False if there was no message
+	* \throw If the message isn't valid
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	template <typename Format>
+	bool tryRead(ISerialisable& result) {
+		Serialisable::JSON read;
+		if (!tryRead<Format>(read))
+			return false;
+		result.fromJSON(read);
+		return true;
+	}
+
+	/*!
+	* \brief Reads the oldest message into an object, waits until there is one
+	* \tparam The format it was written in
+	* \param The object
+	* \throw If the message isn't valid
+	*
+	* \note It calls the overloaded serialisation() method
+	*/
+	template <typename Format>
+	void read(ISerialisable& result) {
+		while (!tryRead<Format>(result))
+			std::this_thread::yield();
+	}
+
+	bool empty() const {
+		return _header->read.load(std::memory_order_acquire) == _header->written.load(std::memory_order_acquire);
+	}
+
+	size_t capacity() const {
+		return _header->capacity;
+	}
+};
+
+#endif // SERIALISABLE_SHM_HPP
@@ -0,0 +1,107 @@
+#include <iostream>
+#include <sys/wait.h>
+#include "serialisable_shm.hpp"
+#include "condensed_json.hpp"
+
+struct Tick : public Serialisable {
+	int64_t sequence = 0;
+	int64_t sentAt = 0;
+	std::string symbol;
+	std::vector<double> prices;
+
+	virtual void serialisation() {
+		synch("sequence", sequence);
+		synch("sent_at", sentAt);
+		synch("symbol", symbol);
+		synch("prices", prices);
+	}
+};
+
+static int64_t now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// The child reads the messages and reports latency percentiles, the parent writes them
+// If paced, every message is sent only after the previous one was read, to measure latency without queueing
+static bool exchange(const std::string& name, int messages, bool paced) {
+	SharedMemoryRing ring = SharedMemoryRing::create(1 << 16);
+	std::cout << std::flush;
+	pid_t child = fork();
+	if (child < 0) {
+		std::cout << "Fork failed" << std::endl;
+		return false;
+	}
+	if (child == 0) {
+		std::vector<int64_t> latencies;
+		latencies.reserve(messages);
+		Tick received;
+		bool correct = true;
+		for (int i = 0; i < messages; i++) {
+			ring.read<CondensedJSON>(received);
+			latencies.push_back(now() - received.sentAt);
+			if (correct && (received.sequence != i || received.prices.size() != size_t(i % 40)
+					|| (!received.prices.empty() && received.prices.back() != i % 64 + 0.5))) {
+				std::cout << "Message " << i << " was received incorrectly" << std::endl;
+				correct = false; // Keep reading, so that the writer isn't stuck
+			}
+		}
+		if (!correct)
+			_exit(1);
+		std::sort(latencies.begin(), latencies.end());
+		auto percentile = [&] (double fraction) {
+			return latencies[std::min(latencies.size() - 1, size_t(latencies.size() * fraction))] / 1000.0;
+		};
+		std::cout << name << " latency: p50 " << percentile(0.5) << " us, p99 " << percentile(0.99)
+				<< " us, p99.9 " << percentile(0.999) << " us" << std::endl;
+		_exit(0);
+	}
+
+	Tick sent;
+	sent.symbol = "DUGI";
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < messages; i++) {
+		sent.sequence = i;
+		sent.prices.resize(i % 40);
+		if (!sent.prices.empty())
+			sent.prices.back() = i % 64 + 0.5; // Exact even in half precision
+		if (paced) {
+			while (!ring.empty())
+				std::this_thread::yield();
+		}
+		sent.sentAt = now();
+		ring.write<CondensedJSON>(sent);
+	}
+	int status = 0;
+	waitpid(child, &status, 0);
+	auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	if (!paced)
+		std::cout << name << " throughput: " << int(messages / elapsed) << " messages/s" << std::endl;
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int main() {
+	{
+		SharedMemoryRing writer = SharedMemoryRing::create("/serialisable_shm_test", 4096);
+		SharedMemoryRing reader = SharedMemoryRing::open("/serialisable_shm_test");
+		Tick sent;
+		sent.symbol = "Text formats are copied through a buffer";
+		sent.prices = { 1.5, 2.5 };
+		writer.write<SerialisableInternals::JSONformat>(sent);
+		Tick received;
+		if (!reader.tryRead<SerialisableInternals::JSONformat>(received) || received.symbol != sent.symbol || received.prices != sent.prices
+				|| reader.tryRead<SerialisableInternals::JSONformat>(received)) {
+			std::cout << "Message in named shared memory was not received correctly" << std::endl;
+			return 1;
+		}
+		sent.prices.resize(5000);
+		try {
+			writer.write<CondensedJSON>(sent);
+			std::cout << "Message larger than the ring was accepted" << std::endl;
+			return 1;
+		} catch (Serialisable::SerialisationError&) { }
+	}
+
+	if (!exchange("Queued", 200000, false) || !exchange("Paced", 20000, true))
+		return 1;
+	return 0;
+}
@@ -0,0 +1,226 @@
+#ifndef SERIALISABLE_SLICED_HPP
+#define SERIALISABLE_SLICED_HPP
+#include "serialisable.hpp"
+#include <functional>
+#include <limits>
+
+/*!
+* \brief Serialises an object in slices of limited duration, so that an event loop can keep running between them
+* \tparam The format, it must have serialiseInto()
+* \tparam The type of the result, anything the format can append to with push_back()
+*
+* \note The work is done by another thread, but only while step() is running, the calling thread waits for it meanwhile,
+* so the object is never accessed by two threads at once
+* \note The serialisation can pause before each object derived from Serialisable and every few kilobytes of output,
+* a container of numbers or a long string is serialised without pausing
+* \note The object must not be serialised elsewhere while this is in progress, because objects don't support reentrant serialisation
+* \note Thread-local settings of the calling thread don't apply, except that shared objects are tracked if they were tracked when it was created
+*/
+template <typename Format = SerialisableInternals::JSONformat, typename Output = std::vector<uint8_t>>
+class SlicedSerialisation {
+	static_assert(SerialisableInternals::WritesIntoSink<Format, Output>::value, "The format must have serialiseInto()");
+	constexpr static int OBJECTS_PER_CLOCK_CHECK = 16;
+	constexpr static size_t BYTES_PER_CLOCK_CHECK = 4096;
+
+	enum class Phase {
+		BUILDING, // Calling toJSON(), modifying the object forces a restart
+		ENCODING, // Writing the complete JSON into the output
+		DONE
+	};
+	struct Restart { }; // Thrown from a checkpoint to abandon the current attempt, not derived from std::exception
+
+	// Passes the output to the format and pauses when the slice has produced enough
+	class Sink {
+		SlicedSerialisation& _parent;
+	public:
+		Sink(SlicedSerialisation& parent) : _parent(parent) { }
+		template <typename Byte>
+		void push_back(Byte written) {
+			_parent._output.push_back(written);
+			if (++_parent._written >= _parent._nextCheck)
+				_parent.checkOutput();
+		}
+	};
+
+	const ISerialisable& _source;
+	std::function<uint64_t()> _version;
+	uint64_t _startVersion = 0;
+	int _maximumRestarts;
+	int _restarts = 0;
+	bool _trackShared;
+	Output _output;
+
+	// Accessed only by the thread whose turn it is
+	Phase _phase = Phase::BUILDING;
+	bool _started = false;
+	std::chrono::steady_clock::time_point _deadline;
+	size_t _written = 0;
+	size_t _sliceEnd = 0; // Value of _written when the slice's byte budget runs out
+	size_t _nextCheck = 0;
+	int _objectsSinceClockCheck = 0;
+	std::exception_ptr _error;
+
+	std::mutex _lock;
+	std::condition_variable _turnChanged;
+	bool _workerTurn = false; // Guarded by _lock
+	bool _restartRequested = false; // Guarded by _lock
+	bool _abandoned = false; // Guarded by _lock
+	std::thread _worker;
+
+	// Called by the worker, returns when it's its turn again, throws if the attempt is to be abandoned
+	void pause() {
+		if (_phase == Phase::BUILDING && _restarts >= _maximumRestarts)
+			return; // Restarted too many times, finish it in one slice
+		std::unique_lock<std::mutex> lock(_lock);
+		_workerTurn = false;
+		_turnChanged.notify_all();
+		_turnChanged.wait(lock, [this] () { return _workerTurn; });
+		if (_abandoned || _restartRequested) {
+			_restartRequested = false;
+			throw Restart();
+		}
+		_objectsSinceClockCheck = 0;
+		_nextCheck = std::min(_written + BYTES_PER_CLOCK_CHECK, _sliceEnd);
+	}
+
+	static void objectReached(void* context) {
+		SlicedSerialisation& self = *static_cast<SlicedSerialisation*>(context);
+		if (++self._objectsSinceClockCheck < OBJECTS_PER_CLOCK_CHECK)
+			return;
+		self._objectsSinceClockCheck = 0;
+		if (std::chrono::steady_clock::now() >= self._deadline)
+			self.pause();
+	}
+
+	void checkOutput() {
+		if (_written >= _sliceEnd || std::chrono::steady_clock::now() >= _deadline)
+			pause();
+		else
+			_nextCheck = std::min(_written + BYTES_PER_CLOCK_CHECK, _sliceEnd);
+	}
+
+	void attempt(Serialisable::JSON& made) {
+		{
+			std::unique_ptr<SerialisableInternals::SharedObjectTracking> tracking;
+			if (_trackShared)
+				tracking = std::make_unique<SerialisableInternals::SharedObjectTracking>();
+			made = _source.toJSON();
+		}
+		_phase = Phase::ENCODING;
+		Sink sink(*this);
+		Format::serialiseInto(made, sink);
+	}
+
+	void run() {
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			_turnChanged.wait(lock, [this] () { return _workerTurn; });
+			if (_abandoned)
+				return;
+		}
+		SerialisableInternals::Checkpoint::active() = { &objectReached, this };
+		SerialisableInternals::BinaryTarget::Scope target(SerialisableInternals::IsBinaryFormat<Format>::value);
+		Serialisable::JSON made;
+		while (true) {
+			try {
+				attempt(made);
+				break;
+			} catch (Restart&) {
+				std::lock_guard<std::mutex> lock(_lock);
+				if (_abandoned)
+					return;
+				_restarts++;
+			} catch (...) {
+				_error = std::current_exception();
+				break;
+			}
+		}
+		SerialisableInternals::Checkpoint::active() = {};
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_phase = Phase::DONE;
+			_workerTurn = false;
+			_turnChanged.notify_all();
+		}
+		made = Serialisable::JSON(); // Freeing a large JSON takes long, it's used only by this thread, so it doesn't need to happen in a slice
+	}
+
+public:
+	/*!
+	* \brief Prepares the serialisation, nothing is serialised until step() is called
+	* \param The object, it must exist until this finishes or is destroyed
+	* \param Optional function returning a number that changes whenever the object is modified, if it changes between slices
+	* before the object is fully converted to JSON, the serialisation starts again, so that the result captures one moment
+	* \param Number of restarts after which the conversion to JSON is finished in one slice, so that it ends even if the object keeps changing
+	*
+	* \note Without a version function, the object must not be modified until step() returns true
+	*/
+	SlicedSerialisation(const ISerialisable& source, std::function<uint64_t()> version = nullptr, int maximumRestarts = 3)
+			: _source(source), _version(std::move(version)), _maximumRestarts(maximumRestarts),
+			_trackShared(SerialisableInternals::SharedObjectTracking::current()) {
+		_worker = std::thread([this] () { run(); });
+	}
+	SlicedSerialisation(const SlicedSerialisation&) = delete;
+	SlicedSerialisation& operator=(const SlicedSerialisation&) = delete;
+
+	// Stops the serialisation if it's not finished
+	~SlicedSerialisation() {
+		{
+			std::lock_guard<std::mutex> lock(_lock);
+			_abandoned = true;
+			_workerTurn = true;
+		}
+		_turnChanged.notify_all();
+		_worker.join();
+	}
+
+	/*!
+	* \brief Serialises a part of the object
+	* \param Approximate time to spend, it can be exceeded by the time needed to serialise an object that isn't derived from Serialisable
+	* \param Maximum number of bytes to output (checked precisely)
+	* \return True if the serialisation is complete
+	* \throw Any exception thrown when serialising the object, later calls throw it again
+	*/
+	bool step(std::chrono::nanoseconds duration, size_t bytes = std::numeric_limits<size_t>::max()) {
+		if (_phase == Phase::DONE) {
+			if (_error)
+				std::rethrow_exception(_error);
+			return true;
+		}
+		{
+			std::unique_lock<std::mutex> lock(_lock);
+			if (_version && _phase == Phase::BUILDING) {
+				uint64_t version = _version();
+				if (_started && version != _startVersion)
+					_restartRequested = true;
+				_startVersion = version;
+			}
+			_started = true;
+			_deadline = std::chrono::steady_clock::now() + duration;
+			_sliceEnd = (bytes > std::numeric_limits<size_t>::max() - _written) ? std::numeric_limits<size_t>::max() : _written + bytes;
+			_workerTurn = true;
+			_turnChanged.notify_all();
+			_turnChanged.wait(lock, [this] () { return !_workerTurn; });
+		}
+		if (_error)
+			std::rethrow_exception(_error);
+		return _phase == Phase::DONE;
+	}
+
+	// True if it's complete, the result can be used
+	bool finished() const {
+		return _phase == Phase::DONE && !_error;
+	}
+
+	// How many times it had to start again because the object was modified
+	int restarts() const {
+		return _restarts;
+	}
+
+	// The serialised object, complete only if finished() is true
+	Output& result() {
+		return _output;
+	}
+};
+
+#endif // SERIALISABLE_SLICED_HPP
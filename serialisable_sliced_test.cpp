@@ -0,0 +1,185 @@
+#include <iostream>
+#include "serialisable_sliced.hpp"
+#include "condensed_json.hpp"
+
+struct Item : public Serialisable {
+	int id = 0;
+	int64_t value = 0;
+	std::string name;
+	std::vector<double> measurements;
+
+	virtual void serialisation() {
+		synch("id", id);
+		synch("value", value);
+		synch("name", name);
+		synch("measurements", measurements);
+	}
+};
+
+struct Document : public Serialisable {
+	int64_t version = 0;
+	std::vector<Item> items;
+
+	virtual void serialisation() {
+		synch("version", version);
+		synch("items", items);
+	}
+
+	// Every item gets the document's version, so a result mixing two versions can be noticed
+	void modify() {
+		version++;
+		for (auto& it : items)
+			it.value = version;
+	}
+};
+
+// Runs the serialisation like an event loop would and reports the longest pause it caused
+template <typename Sliced, typename BetweenSlices>
+static void runSlices(const std::string& name, Sliced& sliced, std::chrono::microseconds slice, BetweenSlices betweenSlices) {
+	int slices = 0;
+	std::chrono::nanoseconds longest(0);
+	auto start = std::chrono::steady_clock::now();
+	while (true) {
+		auto sliceStart = std::chrono::steady_clock::now();
+		bool done = sliced.step(slice);
+		longest = std::max<std::chrono::nanoseconds>(longest, std::chrono::steady_clock::now() - sliceStart);
+		slices++;
+		if (done)
+			break;
+		betweenSlices();
+	}
+	std::cout << name << ": " << slices << " slices, longest " << std::chrono::duration_cast<std::chrono::microseconds>(longest).count()
+			<< " us, total " << std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count()
+			<< " us, " << sliced.restarts() << " restarts" << std::endl;
+}
+
+template <typename Function>
+static long long measure(Function function) {
+	auto start = std::chrono::steady_clock::now();
+	function();
+	return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+static bool consistent(const Document& read, int expectedItems) {
+	if (int(read.items.size()) != expectedItems)
+		return false;
+	for (auto& it : read.items)
+		if (it.value != read.version)
+			return false;
+	return true;
+}
+
+int main() {
+	constexpr int ITEMS = 100000;
+	Document document;
+	document.items.resize(ITEMS);
+	for (int i = 0; i < ITEMS; i++) {
+		document.items[i].id = i;
+		document.items[i].name = "Item number " + std::to_string(i);
+		document.items[i].measurements.resize(i % 8, i * 0.5);
+	}
+	bool correct = true;
+
+	std::vector<uint8_t> expectedJSON;
+	std::cout << "Serialising JSON at once: " << measure([&] () { document.to<SerialisableInternals::JSONformat>(expectedJSON); }) << " us" << std::endl;
+	std::vector<uint8_t> expectedCondensed;
+	std::cout << "Serialising CondensedJSON at once: " << measure([&] () { document.to<CondensedJSON>(expectedCondensed); }) << " us" << std::endl;
+
+	{
+		SlicedSerialisation<> sliced(document);
+		runSlices("JSON in 2 ms slices", sliced, std::chrono::milliseconds(2), [] () {});
+		if (sliced.result() != expectedJSON) {
+			std::cout << "Sliced JSON differs" << std::endl;
+			correct = false;
+		}
+	}
+	{
+		SlicedSerialisation<CondensedJSON> sliced(document);
+		runSlices("CondensedJSON in 2 ms slices", sliced, std::chrono::milliseconds(2), [] () {});
+		if (sliced.result() != expectedCondensed) {
+			std::cout << "Sliced CondensedJSON differs" << std::endl;
+			correct = false;
+		}
+	}
+	{
+		// Limited by the size of the output
+		SlicedSerialisation<> sliced(document);
+		int slices = 1;
+		size_t previous = 0;
+		while (!sliced.step(std::chrono::seconds(1), 100000)) {
+			if (sliced.result().size() - previous > 100000) {
+				std::cout << "Slice wrote " << sliced.result().size() - previous << " bytes" << std::endl;
+				correct = false;
+			}
+			previous = sliced.result().size();
+			slices++;
+		}
+		if (sliced.result() != expectedJSON || slices < int(expectedJSON.size() / 100000)) {
+			std::cout << "JSON in slices of 100000 bytes took " << slices << " slices, differs: " << (sliced.result() != expectedJSON) << std::endl;
+			correct = false;
+		}
+	}
+
+	// Modified while it's being serialised, it must start again
+	{
+		SlicedSerialisation<CondensedJSON> sliced(document, [&] () { return uint64_t(document.version); });
+		int modifications = 0;
+		runSlices("Modified twice", sliced, std::chrono::microseconds(500), [&] () {
+			if (modifications++ < 2)
+				document.modify();
+		});
+		Document read;
+		read.from<CondensedJSON>(sliced.result());
+		if (sliced.restarts() < 1 || !consistent(read, ITEMS) || read.version != document.version) {
+			std::cout << "Modified twice: wrong result" << std::endl;
+			correct = false;
+		}
+	}
+	{
+		// It never stops changing, so it must finish without pausing after the restarts
+		SlicedSerialisation<CondensedJSON> sliced(document, [&] () { return uint64_t(document.version); }, 3);
+		runSlices("Modified all the time", sliced, std::chrono::microseconds(500), [&] () { document.modify(); });
+		Document read;
+		read.from<CondensedJSON>(sliced.result());
+		if (sliced.restarts() != 3 || !consistent(read, ITEMS)) {
+			std::cout << "Modified all the time: wrong result" << std::endl;
+			correct = false;
+		}
+	}
+
+	// Exceptions come out of step()
+	{
+		struct Failing : public Serialisable {
+			Document contents;
+			virtual void serialisation() {
+				synch("contents", contents);
+				throw std::runtime_error("Failing on purpose");
+			}
+		} failing;
+		failing.contents.items.resize(1000);
+		SlicedSerialisation<> sliced(failing);
+		try {
+			while (!sliced.step(std::chrono::microseconds(100)));
+			std::cout << "Exception was lost" << std::endl;
+			correct = false;
+		} catch (std::runtime_error& error) {
+			if (std::string(error.what()) != "Failing on purpose") {
+				std::cout << "Wrong exception: " << error.what() << std::endl;
+				correct = false;
+			}
+		}
+	}
+
+	// Destroyed before it finished
+	{
+		SlicedSerialisation<> sliced(document);
+		sliced.step(std::chrono::microseconds(100));
+	}
+	{
+		SlicedSerialisation<> sliced(document);
+	}
+
+	if (correct)
+		std::cout << "Sliced serialisation works correctly" << std::endl;
+	return correct ? 0 : 1;
+}
@@ -1,11 +1,28 @@
 #include <iostream>
 #include "serialisable.hpp"
+#include "condensed_json.hpp"
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+#include <csignal>
+#include <sys/resource.h>
+#endif
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 enum DocumentType {
 	BOOK = 1,
 	ESSAY
 };
 
+namespace SerialisableInternals {
+template <>
+struct EnumNames<DocumentType> {
+	constexpr static std::array<EnumName<DocumentType>, 2> names() {
+		return {{ { BOOK, "book" }, { ESSAY, "essay" } }};
+	}
+};
+}
+
 struct Chapter : public Serialisable {
 	std::string contents = "";
 	std::string author = "Anonymous";
@@ -18,6 +35,58 @@ struct Chapter : public Serialisable {
 	}
 };
 
+// Its members are named like the markup of shared objects
+struct Marked : public Serialisable {
+	double reference = 0;
+	std::string identifier;
+
+	virtual void serialisation() {
+		synch("$ref", reference);
+		synch("$id", identifier);
+	}
+};
+
+struct MarkedList : public Serialisable {
+	std::vector<std::shared_ptr<Marked>> items;
+
+	virtual void serialisation() {
+		synch("items", items);
+	}
+};
+
+// Identified by its number only, the note is optional
+struct Tagged : public Serialisable {
+	int id = 0;
+	std::string note;
+
+	virtual void serialisation() {
+		synch("id", id);
+		synch("note", note);
+	}
+	bool operator<(const Tagged& other) const {
+		return id < other.id;
+	}
+	bool operator==(const Tagged& other) const {
+		return id == other.id;
+	}
+};
+
+namespace std {
+template <>
+struct hash<Tagged> {
+	size_t operator()(const Tagged& tagged) const {
+		return std::hash<int>()(tagged.id);
+	}
+};
+}
+
+#if __cplusplus > 201402L
+template <>
+struct SerialisableInternals::VariantAlternativeName<Chapter> {
+	constexpr static const char* name = "chapter";
+};
+#endif
+
 struct Preferences : public Serialisable {
 	std::string lastFolder = "";
 	unsigned int lastOpen = 0;
@@ -32,8 +101,17 @@ struct Preferences : public Serialisable {
 	std::vector<std::unique_ptr<Chapter>> addenda;
 	std::shared_ptr<Serialisable::JSON> customValue;
 	std::vector<uint8_t> raw;
+	std::map<std::string, int> wordCounts;
+	std::set<std::string> tags;
+	std::list<std::pair<int, std::string>> revisions;
+	std::tuple<int, double, std::string> version;
+	std::unordered_map<uint64_t, std::string> owners;
+	std::map<DocumentType, int> countsByType;
+	std::chrono::system_clock::time_point lastSaved;
+	std::chrono::milliseconds editingTime = std::chrono::milliseconds(0);
 #if __cplusplus > 201402L
 	std::optional<std::string> critique;
+	std::variant<int, std::string, Chapter> attachment;
 #endif
 
 	virtual void serialisation() {
@@ -50,12 +128,31 @@ struct Preferences : public Serialisable {
 		synch("addenda", addenda);
 		synch("custom_value", customValue);
 		synch("raw", raw);
+		synch("word_counts", wordCounts);
+		synch("tags", tags);
+		synch("revisions", revisions);
+		synch("version", version);
+		synch("owners", owners);
+		synch("counts_by_type", countsByType);
+		synch("last_saved", lastSaved);
+		synch("editing_time", editingTime);
 #if __cplusplus > 201402L
 		synch("critique", critique);
+		synch("attachment", attachment);
 #endif
 	}
 };
 
+#ifdef __linux__
+static size_t residentMegabytes() {
+	std::ifstream file("/proc/self/statm");
+	size_t total = 0;
+	size_t resident = 0;
+	file >> total >> resident;
+	return resident * size_t(sysconf(_SC_PAGESIZE)) >> 20;
+}
+#endif
+
 int main() {
 	Serialisable::JSON testJson;
 	testJson.setObject()["file"] = "test.json";
@@ -81,6 +178,12 @@ int main() {
 	testReadJson["float_number"] = 4.9;
 	testReadJson.save("test-reread.json");
 
+	const Serialisable::Schema& schema = Serialisable::schema<Preferences>();
+	if (schema.fields.front().name != "last_folder" || *schema.fields[6].type != typeid(DocumentType)) {
+		std::cout << "Schema was not recorded correctly" << std::endl;
+		return 1;
+	}
+
 	Preferences prefs;
 	prefs.load("prefs.json");
 	prefs.footnotes.push_back(std::make_shared<Chapter>());
@@ -88,7 +191,396 @@ int main() {
 	prefs.footnotes.back()->author = "Dugi";
 	prefs.documentType = ESSAY;
 	prefs.raw.push_back(13);
+	prefs.wordCounts["footnotes"] += 6;
+	prefs.tags.insert("essay");
+	prefs.revisions.emplace_back(int(prefs.revisions.size()), "Added a footnote");
+	std::get<0>(prefs.version)++;
+	prefs.owners[UINT64_MAX - 1] = "Dugi";
+	prefs.owners[prefs.owners.size()] = "Anonymous";
+	prefs.countsByType[ESSAY]++;
+	prefs.lastSaved = std::chrono::system_clock::now();
+	prefs.editingTime += std::chrono::milliseconds(1500);
+#if __cplusplus > 201402L
+	if (prefs.attachment.index() == 0)
+		prefs.attachment = Chapter();
+	else
+		std::get<Chapter>(prefs.attachment).contents += "!";
+#endif
 	prefs.save("prefs.json");
 
+	Preferences reloaded;
+	reloaded.wordCounts["removed"] = 1;
+	reloaded.load("prefs.json");
+	if (reloaded.wordCounts != prefs.wordCounts || reloaded.tags != prefs.tags || reloaded.revisions != prefs.revisions
+			|| reloaded.version != prefs.version || reloaded.owners != prefs.owners || reloaded.countsByType != prefs.countsByType
+			|| reloaded.lastSaved != prefs.lastSaved || reloaded.editingTime != prefs.editingTime || reloaded.documentType != ESSAY
+#if __cplusplus > 201402L
+			|| std::get<Chapter>(reloaded.attachment).contents != std::get<Chapter>(prefs.attachment).contents
+#endif
+			) {
+		std::cout << "Standard containers were not reloaded correctly" << std::endl;
+		return 1;
+	}
+	{
+		// Enums are saved by name, except into binary formats, unknown names are rejected
+		using Serialiser = SerialisableInternals::Serialiser<DocumentType, void>;
+		DocumentType parsed = BOOK;
+		Serialiser::deserialise(parsed, Serialisable::JSON("essay"));
+		bool binaryAsNumber = false;
+		{
+			SerialisableInternals::BinaryTarget::Scope target(true);
+			binaryAsNumber = (Serialiser::serialise(ESSAY).type() == Serialisable::JSON::Type::NUMBER);
+		}
+		bool rejected = false;
+		try {
+			DocumentType unknown = BOOK;
+			Serialiser::deserialise(unknown, Serialisable::JSON("novel"));
+		} catch (Serialisable::SerialisationError&) {
+			rejected = true;
+		}
+		if (parsed != ESSAY || Serialiser::serialise(BOOK).string() != "book" || !binaryAsNumber || !rejected) {
+			std::cout << "Enums with names were not serialised correctly" << std::endl;
+			return 1;
+		}
+	}
+	{
+		// Dates and times out of range are rejected
+		using Serialiser = SerialisableInternals::Serialiser<std::chrono::system_clock::time_point, void>;
+		std::chrono::system_clock::time_point parsed;
+		Serialiser::deserialise(parsed, Serialisable::JSON("2024-02-29T23:59:60+01:30"));
+		for (const char* invalid : { "2024-02-30T00:00:00Z", "2023-02-29T00:00:00Z", "2024-04-31T00:00:00Z", "2024-01-01T24:00:00Z",
+				"2024-01-01T25:61:99Z", "2024-01-01T00:60:00Z", "2024-01-01T00:00:61Z", "2024-01-01T00:00:00+24:00", "2024-01-01T00:00:00+01:60" }) {
+			try {
+				Serialiser::deserialise(parsed, Serialisable::JSON(invalid));
+				std::cout << "Invalid date and time " << invalid << " was not rejected" << std::endl;
+				return 1;
+			} catch (Serialisable::SerialisationError&) { }
+		}
+		// Durations too long for their type are rejected rather than wrapping around
+		using DurationSerialiser = SerialisableInternals::Serialiser<std::chrono::nanoseconds, void>;
+		std::chrono::nanoseconds duration;
+		DurationSerialiser::deserialise(duration, Serialisable::JSON("-9223372036854775808"));
+		if (duration != std::chrono::nanoseconds::min()) {
+			std::cout << "The shortest duration was not loaded" << std::endl;
+			return 1;
+		}
+		for (const Serialisable::JSON& invalid : { Serialisable::JSON("9223372036854775808"), Serialisable::JSON("-9223372036854775809"),
+				Serialisable::JSON("100000000000000000000"), Serialisable::JSON(1e30) }) {
+			try {
+				DurationSerialiser::deserialise(duration, invalid);
+				std::cout << "Duration out of range " << invalid.toString() << " was not rejected" << std::endl;
+				return 1;
+			} catch (Serialisable::SerialisationError&) { }
+		}
+	}
+	{
+		// Binary formats store numeric keys as numbers rather than text
+		Preferences binary;
+		binary.countsByType[ESSAY] = 3;
+		binary.countsByType[BOOK] = 7;
+		binary.owners[12] = "Dugi";
+		Serialisable::JSON json;
+		{
+			SerialisableInternals::BinaryTarget::Scope target(true);
+			json = binary.toJSON();
+		}
+		Preferences fromBinary;
+		fromBinary.from<CondensedJSON>(binary.to<CondensedJSON>());
+		if (json["counts_by_type"].type() != Serialisable::JSON::Type::ARRAY
+				|| fromBinary.countsByType != binary.countsByType || fromBinary.owners != binary.owners) {
+			std::cout << "Numeric map keys were not reloaded from a binary format" << std::endl;
+			return 1;
+		}
+
+		// Keys that don't fit into the key type are rejected in both forms
+		auto rejected = [] (const Serialisable::JSON& source) {
+			std::map<int32_t, int> small;
+			try {
+				SerialisableInternals::Serialiser<std::map<int32_t, int>, void>::deserialise(small, source);
+			} catch (Serialisable::SerialisationError&) {
+				return true;
+			}
+			return false;
+		};
+		Serialisable::JSON limits;
+		limits.setObject()["-2147483648"] = 1;
+		limits["2147483647"] = 2;
+		std::map<int32_t, int> loaded;
+		SerialisableInternals::Serialiser<std::map<int32_t, int>, void>::deserialise(loaded, limits);
+		Serialisable::JSON tooLarge;
+		tooLarge.setObject()["99999999999"] = 1;
+		Serialisable::JSON tooSmall;
+		tooSmall.setObject()["-2147483649"] = 1;
+		Serialisable::JSON largeNumber;
+		largeNumber.setArray().push_back(Serialisable::JSON(1e11));
+		largeNumber.push_back(Serialisable::JSON(1));
+		Serialisable::JSON fraction;
+		fraction.setArray().push_back(Serialisable::JSON(1.5));
+		fraction.push_back(Serialisable::JSON(1));
+		if (loaded.size() != 2 || loaded.begin()->first != INT32_MIN || !rejected(tooLarge) || !rejected(tooSmall)
+				|| !rejected(largeNumber) || !rejected(fraction)) {
+			std::cout << "Numeric map keys out of range were not rejected" << std::endl;
+			return 1;
+		}
+	}
+	{
+		Preferences sharing;
+		sharing.footnotes.push_back(std::make_shared<Chapter>());
+		sharing.footnotes.push_back(sharing.footnotes.front());
+		std::string saved;
+		{
+			SerialisableInternals::SharedObjectTracking tracking;
+			saved = sharing.toString();
+		}
+		SerialisableInternals::SharedObjectTracking tracking;
+		Preferences restored;
+		restored.fromString(saved);
+		if (restored.footnotes.size() != 2 || restored.footnotes[0] != restored.footnotes[1]) {
+			std::cout << "Shared objects were not restored as shared" << std::endl;
+			return 1;
+		}
+	}
+	{
+		// Elements loaded into reused nodes don't keep members of the elements that were there before
+		Serialisable::JSON noted = Serialisable::JSON::fromString("[{\"id\": 1, \"note\": \"first\"}, {\"id\": 2, \"note\": \"second\"}]");
+		Serialisable::JSON plain = Serialisable::JSON::fromString("[{\"id\": 3}, {\"id\": 4}]");
+		Serialisable::JSON notedMap = Serialisable::JSON::fromString("{\"a\": {\"id\": 1, \"note\": \"first\"}}");
+		Serialisable::JSON plainMap = Serialisable::JSON::fromString("{\"b\": {\"id\": 2}}");
+		std::set<Tagged> ordered;
+		std::unordered_set<Tagged> hashed;
+		std::map<std::string, Tagged> mapped;
+		SerialisableInternals::Serialiser<std::set<Tagged>, void>::deserialise(ordered, noted);
+		SerialisableInternals::Serialiser<std::set<Tagged>, void>::deserialise(ordered, plain);
+		SerialisableInternals::Serialiser<std::unordered_set<Tagged>, void>::deserialise(hashed, noted);
+		SerialisableInternals::Serialiser<std::unordered_set<Tagged>, void>::deserialise(hashed, plain);
+		SerialisableInternals::Serialiser<std::map<std::string, Tagged>, void>::deserialise(mapped, notedMap);
+		SerialisableInternals::Serialiser<std::map<std::string, Tagged>, void>::deserialise(mapped, plainMap);
+		bool clean = ordered.size() == 2 && hashed.size() == 2 && mapped.size() == 1 && mapped.at("b").id == 2 && mapped.at("b").note.empty();
+		for (auto& it : ordered)
+			clean = clean && it.id >= 3 && it.note.empty();
+		for (auto& it : hashed)
+			clean = clean && it.id >= 3 && it.note.empty();
+		if (!clean) {
+			std::cout << "Reused nodes kept values of other elements" << std::endl;
+			return 1;
+		}
+	}
+	{
+		// Every file saved or loaded in one tracking scope stands on its own
+		Preferences sharing;
+		sharing.footnotes.push_back(std::make_shared<Chapter>());
+		sharing.footnotes.front()->author = "Shared";
+		sharing.footnotes.push_back(sharing.footnotes.front());
+		SerialisableInternals::SharedObjectTracking tracking;
+		std::string first = sharing.toString();
+		std::string second = sharing.toString();
+		Preferences restored;
+		restored.fromString(second);
+		Preferences restoredAgain;
+		restoredAgain.fromString(first);
+		if (first != second || restored.footnotes.size() != 2 || restored.footnotes[0] != restored.footnotes[1]
+				|| restored.footnotes[0]->author != "Shared" || restoredAgain.footnotes[0]->author != "Shared"
+				|| restoredAgain.footnotes[0] == restored.footnotes[0]) {
+			std::cout << "Shared objects depend on files saved or loaded before in the same scope" << std::endl;
+			return 1;
+		}
+	}
+	{
+		// Members named like the markup are not mistaken for it
+		MarkedList marked;
+		marked.items.push_back(std::make_shared<Marked>());
+		marked.items.front()->reference = 7;
+		marked.items.front()->identifier = "first";
+		marked.items.push_back(marked.items.front());
+		marked.items.push_back(std::make_shared<Marked>());
+		marked.items.back()->reference = 3;
+		for (int format = 0; format < 2; format++) {
+			SerialisableInternals::SharedObjectTracking tracking;
+			MarkedList restored;
+			if (format == 0)
+				restored.fromString(marked.toString());
+			else
+				restored.fromJSON(Serialisable::JSON::from<CondensedJSON>(marked.to<CondensedJSON>()));
+			if (restored.items.size() != 3 || restored.items[0] != restored.items[1] || restored.items[0]->reference != 7
+					|| restored.items[0]->identifier != "first" || restored.items[2]->reference != 3 || restored.items[2] == restored.items[0]) {
+				std::cout << "Members named like the markup of shared objects were misread" << std::endl;
+				return 1;
+			}
+		}
+	}
+#ifdef SERIALISABLE_BY_DUGI_POSIX_FILES
+	{
+		// A save that cannot be written throws and leaves the previous file as it was, whether it fits into one chunk or not
+		Preferences large;
+		large.chapters.resize(20000); // Larger than one chunk
+		Preferences small;
+		small.chapters.resize(5);
+		signal(SIGXFSZ, SIG_IGN);
+		for (std::pair<Preferences*, rlim_t> attempt : { std::make_pair(&large, rlim_t(100000)), std::make_pair(&small, rlim_t(100)) }) {
+			rlimit previous;
+			getrlimit(RLIMIT_FSIZE, &previous);
+			rlimit limited = previous;
+			limited.rlim_cur = attempt.second;
+			setrlimit(RLIMIT_FSIZE, &limited);
+			bool thrown = false;
+			try {
+				attempt.first->save("prefs.json");
+			} catch (std::runtime_error&) {
+				thrown = true;
+			}
+			setrlimit(RLIMIT_FSIZE, &previous);
+			Preferences kept;
+			kept.load("prefs.json");
+			if (!thrown || kept.chapters.size() != prefs.chapters.size() || kept.wordCounts != prefs.wordCounts
+					|| std::ifstream("prefs.json.saving").is_open()) {
+				std::cout << "Failed save was not reported or damaged the previous file" << std::endl;
+				return 1;
+			}
+		}
+	}
+#endif
+#if __cplusplus > 201402L
+	{
+		// Repeated alternatives are told apart by their index, an empty variant is saved as null
+		using Repeated = std::variant<std::monostate, int, int, Chapter, Chapter>;
+		for (size_t index = 0; index < std::variant_size_v<Repeated>; index++) {
+			Repeated saved;
+			if (index == 1)
+				saved.emplace<1>(10);
+			else if (index == 2)
+				saved.emplace<2>(20);
+			else if (index == 3)
+				saved.emplace<3>().contents = "third";
+			else if (index == 4)
+				saved.emplace<4>().contents = "fourth";
+			Serialisable::JSON json = SerialisableInternals::Serialiser<Repeated, void>::serialise(saved);
+			if (index == 0 && json.object().begin()->second.type() != Serialisable::JSON::Type::NIL) {
+				std::cout << "Empty variant alternative was not saved as null" << std::endl;
+				return 1;
+			}
+			for (int format = 0; format < 2; format++) {
+				Repeated loaded(std::in_place_index<3>);
+				Serialisable::JSON reparsed;
+				if (format == 0)
+					reparsed = Serialisable::JSON::fromString(json.toString());
+				else {
+					SerialisableInternals::BinaryTarget::Scope target(true); // Saved as [index, value]
+					reparsed = Serialisable::JSON::from<CondensedJSON>(SerialisableInternals::Serialiser<Repeated, void>::serialise(saved).to<CondensedJSON>());
+				}
+				SerialisableInternals::Serialiser<Repeated, void>::deserialise(loaded, reparsed);
+				if (loaded.index() != index || (index == 1 && std::get<1>(loaded) != 10) || (index == 2 && std::get<2>(loaded) != 20)
+						|| (index == 3 && std::get<3>(loaded).contents != "third") || (index == 4 && std::get<4>(loaded).contents != "fourth")) {
+					std::cout << "Variant alternative " << index << " was not reloaded in format " << format << std::endl;
+					return 1;
+				}
+			}
+		}
+	}
+#endif
+	{
+		// Strings are escaped both in indented and in compact JSON
+		Serialisable::JSON quoted;
+		quoted.setObject()["text"] = "She said \"no\"\nback\\slash";
+		std::string indented = quoted.toString();
+		std::string compact = SerialisableInternals::CompactJSONformat::serialise(quoted);
+		if (Serialisable::JSON::fromString(indented)["text"].string() != quoted["text"].string()
+				|| Serialisable::JSON::fromString(compact)["text"].string() != quoted["text"].string()) {
+			std::cout << "Strings with quotes, line breaks or backslashes were not saved correctly" << std::endl;
+			return 1;
+		}
+	}
+	{
+		// Files that can't be opened or read are reported, except when loading an object, which is left as it was
+		for (const char* unreadable : { "missing_file.json", "." }) {
+			try {
+				Serialisable::JSON::load(unreadable);
+				std::cout << "Loading " << unreadable << " did not fail" << std::endl;
+				return 1;
+			} catch (std::runtime_error&) { }
+		}
+		Preferences untouched;
+		untouched.load("missing_file.json");
+		if (untouched.chapters.size() != 0) {
+			std::cout << "Loading a missing file changed the object" << std::endl;
+			return 1;
+		}
+	}
+	if (prefs.memoryUsageByKey()["footnotes"].total() == 0) {
+		std::cout << "Memory usage was not computed" << std::endl;
+		return 1;
+	}
+	{
+		// Each category is counted, a subtree shared by two members is counted once
+		Serialisable::JSON shared;
+		Serialisable::JSON::ArrayType& elements = shared.setArray();
+		for (int i = 0; i < 100; i++)
+			elements.push_back(Serialisable::JSON(i));
+		Serialisable::JSON text = std::string(100, 'x');
+		Serialisable::JSON once;
+		once.setObject()["first"] = shared;
+		once["text"] = text;
+		Serialisable::JSON twice;
+		twice.setObject()["first"] = shared;
+		twice["second"] = shared;
+		twice["text"] = text;
+		Serialisable::JSON::MemoryUsage array = shared.memoryUsage();
+		Serialisable::JSON::MemoryUsage onceUsage = once.memoryUsage();
+		Serialisable::JSON::MemoryUsage twiceUsage = twice.memoryUsage();
+		if (array.arrays < 100 * sizeof(Serialisable::JSON) || array.objects != 0 || array.strings != 0
+				|| onceUsage.arrays != array.arrays || onceUsage.strings < 100 || onceUsage.objects == 0
+				|| twiceUsage.arrays != array.arrays || twiceUsage.strings != onceUsage.strings) {
+			std::cout << "Memory usage categories were not computed correctly" << std::endl;
+			return 1;
+		}
+	}
+
+#ifdef __linux__
+	{
+		// Nodes made by one thread and freed by another are reused, the memory doesn't grow with the number of handed over nodes
+		std::mutex lock;
+		std::condition_variable changed;
+		Serialisable::JSON handed;
+		bool full = false;
+		constexpr int ROUNDS = 300;
+		std::thread producer([&] {
+			for (int round = 0; round < ROUNDS; round++) {
+				Serialisable::JSON made;
+				made.setArray();
+				for (int i = 0; i < 10000; i++) {
+					Serialisable::JSON element;
+					element.setObject()["index"] = i;
+					made.array().push_back(element);
+				}
+				std::unique_lock<std::mutex> guard(lock);
+				changed.wait(guard, [&] { return !full; });
+				handed = made;
+				made = Serialisable::JSON(); // The consumer releases the last reference
+				full = true;
+				changed.notify_all();
+			}
+		});
+		size_t warmedUp = 0;
+		for (int round = 0; round < ROUNDS; round++) {
+			Serialisable::JSON taken;
+			{
+				std::unique_lock<std::mutex> guard(lock);
+				changed.wait(guard, [&] { return full; });
+				taken = handed;
+				handed = Serialisable::JSON();
+				full = false;
+				changed.notify_all();
+			}
+			taken = Serialisable::JSON();
+			if (round == 20)
+				warmedUp = residentMegabytes();
+		}
+		producer.join();
+		if (residentMegabytes() > warmedUp + 32) {
+			std::cout << "Memory grew from " << warmedUp << " MiB to " << residentMegabytes() << " MiB when freeing nodes in another thread" << std::endl;
+			return 1;
+		}
+	}
+#endif
+
 	return 0;
 }
@@ -0,0 +1,72 @@
+#define SERIALISABLE_BY_DUGI_TRACE
+#include <iostream>
+#include <thread>
+#include "serialisable.hpp"
+
+struct Point : public Serialisable {
+	double x = 0;
+	double y = 0;
+
+	virtual void serialisation() {
+		synch("x", x);
+		synch("y", y);
+	}
+};
+
+struct Path : public Serialisable {
+	std::string name;
+	std::vector<Point> points;
+
+	virtual void serialisation() {
+		synch("name", name);
+		synch("points", points);
+	}
+};
+
+int main() {
+	bool correct = true;
+	const std::string fileName = "trace_test.json";
+	Path path;
+	path.name = "traced";
+	path.points.resize(1000);
+
+	// The spans are recorded by another thread, the thread saving them is registered while saving, the output is over a chunk long
+	Serialisable::Tracing::start();
+	std::thread worker([&] {
+		path.toJSON();
+	});
+	worker.join();
+	Serialisable::Tracing::save(fileName);
+	Serialisable::Tracing::stop();
+
+	Serialisable::JSON saved = Serialisable::JSON::load(fileName);
+	const Serialisable::JSON::ArrayType& events = saved["traceEvents"].array();
+	int pointSpans = 0;
+	for (const Serialisable::JSON& event : events)
+		if (event["name"].string() == "Point::toJSON")
+			pointSpans++;
+	if (pointSpans != 1000) {
+		std::cout << "Saved " << pointSpans << " spans of serialised points instead of 1000" << std::endl;
+		correct = false;
+	}
+
+	// Spans recorded while saving the trace are not in the file, the ones recorded later are in the next one
+	Serialisable::Tracing::clear();
+	Serialisable::Tracing::start();
+	path.points.resize(10);
+	path.toJSON();
+	Serialisable::Tracing::save(fileName);
+	Serialisable::Tracing::stop();
+	saved = Serialisable::JSON::load(fileName);
+	for (const Serialisable::JSON& event : saved["traceEvents"].array())
+		if (event["cat"].string() == "file") {
+			std::cout << "Saving the trace was traced" << std::endl;
+			correct = false;
+			break;
+		}
+	remove(fileName.c_str());
+
+	if (correct)
+		std::cout << "Tracing works correctly" << std::endl;
+	return correct ? 0 : 1;
+}